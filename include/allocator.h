@@ -4,6 +4,10 @@
 #include <set>
 #include <iterator>
 #include<unordered_map>
+#include<string>
+#include "stats.h"
+#include "checkpoint.h"
+#include<memory>
 struct block {
     std::size_t addr; 
     std::size_t len;  
@@ -38,11 +42,16 @@ public:
     int allocate_bestfit(std::size_t size);
     int allocate_worstfit(std::size_t size);
     void free(int id);
+    // Offset and length of an allocated block; false if the id is not live
+    bool block_at(int id, std::size_t &addr, std::size_t &len) const;
     void dump() const;
     double ext_frag() const;
     double alloc_success_rate() const;
     std::size_t total_memory() const;
     std::size_t used_memory() const;
+    void registerStats(stats::Registry &registry);
+    void save(CheckpointWriter &out) const;
+    static std::unique_ptr<Memory> restore(CheckpointReader &in);
 
 private:
     std::size_t totalsize;
@@ -56,4 +65,12 @@ private:
     void del_index(std::list<block>::iterator it);
     void addblock(std::list<block>::iterator it, std::size_t size);
     std::size_t usedmemory;
+    stats::Counter *stat_attempts = nullptr;
+    stats::Counter *stat_successes = nullptr;
+    stats::Counter *stat_frees = nullptr;
+    stats::Histogram *stat_block_size = nullptr;
+    stats::Gauge *stat_ext_frag = nullptr;
+    stats::Gauge *stat_used = nullptr;
+    stats::Gauge *stat_free_blocks = nullptr;
+    void update_gauges();
 };
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include "stats.h"
+
+// Fixed-granularity heap: one bit per allocation unit (1 = allocated).
+// Allocation is first fit at the lowest address, like
+// Memory::allocate_firstfit on unit-rounded sizes. Two summary levels keep
+// the search short: a bit per 64-unit word that is completely allocated,
+// and per 4096-unit group bounds on the longest free run and the free runs
+// at either end. Groups that cannot hold the request are skipped whole;
+// inside a group, free runs are found with count-trailing-zeros over words
+// and free stretches are checked two words at a time with SSE2 where
+// available. Freeing clears the block's bits;
+// there is no block list to coalesce.
+class BitmapMemory {
+public:
+    BitmapMemory(std::size_t size, std::size_t unit);
+    int allocate(std::size_t size);
+    void free(int id);
+    // Offset and length (whole units) of an allocated block
+    bool block_at(int id, std::size_t &addr, std::size_t &len) const;
+    void dump() const;
+    // 1 - largest free run / free bytes; scans the bitmap
+    double ext_frag() const;
+    // unit round-up waste over allocated bytes
+    double int_frag() const;
+    double alloc_success_rate() const;
+    std::size_t total_memory() const;
+    std::size_t used_memory() const;
+    std::size_t unit_size() const;
+    // Counters and used bytes only: ext_frag is a full scan, so no gauge
+    void registerStats(stats::Registry &registry);
+
+    static const std::size_t NONE = ~(std::size_t)0;
+
+private:
+    struct span {
+        std::size_t first;
+        std::size_t count;
+        std::size_t requested;
+    };
+    std::size_t unit;
+    std::size_t units;
+    std::vector<uint64_t> bits; // bits past the last unit stay set
+    std::vector<uint64_t> full; // bit w: bits[w] is all ones
+    // Upper bounds on the free runs of each 64-word group: allocating only
+    // shrinks runs, a failed search tightens them and a free widens them to
+    // the merged run.
+    static const std::size_t GROUP_UNITS = 64 * 64;
+    struct group_info {
+        std::size_t prefix = 0;  // free units at the start
+        std::size_t suffix = 0;  // free units at the end
+        std::size_t largest = 0; // longest free run inside
+    };
+    std::vector<group_info> groups; // one per summary word
+    std::size_t hint = 0;       // every unit below is allocated
+    std::unordered_map<int, span> live;
+    int next_id = 1;
+    long long attempts = 0;
+    long long hits = 0;
+    std::size_t used_units = 0;
+    std::size_t requested_bytes = 0;
+    stats::Counter *stat_attempts = nullptr;
+    stats::Counter *stat_successes = nullptr;
+    stats::Counter *stat_frees = nullptr;
+    stats::Histogram *stat_block_size = nullptr;
+    stats::Gauge *stat_used = nullptr;
+
+    std::size_t next_free(std::size_t pos) const;
+    // first allocated unit in [pos, limit), or limit
+    std::size_t free_run_end(std::size_t pos, std::size_t limit) const;
+    // first unit of the free run that reaches up to pos
+    std::size_t free_run_start(std::size_t pos) const;
+    void widen_groups(std::size_t first, std::size_t end);
+    std::size_t find_run(std::size_t count);
+    void set_range(std::size_t first, std::size_t count);
+    void clear_range(std::size_t first, std::size_t count);
+};
+
+// Replays one random malloc/free sequence against first fit, best fit and
+// the bitmap on fresh heaps of `size` bytes and prints throughput. Sizes are
+// rounded up to `unit` for all three so first fit and the bitmap must agree
+// on every placement, which the report checks.
+void bench_allocators(std::size_t size, std::size_t unit, uint64_t ops, std::size_t max_size, uint64_t seed);
@@ -3,18 +3,73 @@
 #include <vector>
 #include <list>
 #include <unordered_map>
+#include <unordered_set>
+#include <memory>
+#include <deque>
 #include <cstdint>
 #include <cstddef>
+#include <string>
+#include "stats.h"
+#include "prefetcher.h"
+#include "missbuffers.h"
+#include "checkpoint.h"
 
 class Cache {
 public:
     Cache(size_t cacheSize, size_t blockSize, int associativity, bool useLRU);
     Cache(size_t cSize, size_t bSize, int assoc);
     bool access(uint64_t physicalAddress,bool write);
+    // access() on each of count addresses in order, writing hit flags to
+    // hitFlags (may be null). Set indices are decoded up front so the host
+    // can prefetch set state ahead of use.
+    void accessBatch(const uint64_t *physicalAddresses, const bool *writes, size_t count, bool *hitFlags);
+    // Functional warming: updates tags and replacement state only, no statistics
+    bool warm(uint64_t physicalAddress, bool write);
+    // Installs a block without counting a demand access; false if already present
+    bool prefetchFill(uint64_t physicalAddress);
+    bool contains(uint64_t physicalAddress) const;
+    // Drops the block if present (coherence invalidation); true if it was cached
+    bool invalidate(uint64_t physicalAddress);
+    // True if the most recent access hit a line brought in by a prefetch
+    bool lastHitWasPrefetched() const;
+    // Block displaced by the most recent demand fill; false if none was
+    bool lastEviction(uint64_t &blockAddr) const;
     uint64_t getHits() const;
     uint64_t getMisses() const;
     double getHitRate() const;
+    size_t getBlockSize() const;
+    size_t getSize() const;
+    int getAssociativity() const;
+    size_t getNumSets() const;
+    // Sets whose lines exist; the rest have never been accessed
+    size_t getTouchedSets() const;
+    bool usesLRU() const;
     void dump() const;
+    void registerStats(stats::Registry &registry, const std::string &prefix);
+    // Geometry, touched sets and their replacement state; statistics counters included
+    void save(CheckpointWriter &out) const;
+    static std::unique_ptr<Cache> restore(CheckpointReader &in);
+
+    struct PrefetchStats {
+        uint64_t fills = 0;     // prefetched lines installed
+        uint64_t useful = 0;    // first demand hit on a prefetched line
+        uint64_t unused = 0;    // prefetched lines evicted before any demand use
+        uint64_t pollution = 0; // demand misses on lines a prefetch evicted
+    };
+    const PrefetchStats &getPrefetchStats() const;
+
+    // 3C breakdown of demand misses: first touch (compulsory), a miss that a
+    // fully associative LRU cache of the same size would also take
+    // (capacity), or one it would have hit (conflict). Off by default since
+    // the shadow cache costs a hash lookup per access.
+    struct MissTypes {
+        uint64_t compulsory = 0;
+        uint64_t capacity = 0;
+        uint64_t conflict = 0;
+    };
+    void classifyMisses(bool on);
+    // nullptr while classification is off
+    const MissTypes *getMissTypes() const;
 
 private:
     struct DecodedAddress {
@@ -28,12 +83,18 @@ private:
         uint64_t tag = 0;
         uint64_t phyAddr = 0;
         bool modified = false;
+        bool prefetched = false; // filled by a prefetch, not yet demanded
     };
 
+    // Lines and replacement state of one set, allocated on its first access
     struct CacheSet {
         std::vector<CacheLine> lines;
+        int fifoNextVictim = 0;
+        std::list<int> lruList; // ways, MRU at front
+        std::vector<std::list<int>::iterator> lruPos; // way -> node in lruList
     };
-    std::vector<CacheSet> sets;
+    std::vector<std::unique_ptr<CacheSet>> sets; // null until touched
+    size_t touchedSets = 0;
     size_t blockSize;
     int associativity;
     size_t numSets;
@@ -42,22 +103,76 @@ private:
     int indexBits;
     uint64_t hits = 0;
     uint64_t misses = 0;
-    std::vector<int> fifoNextVictim;
-    std::vector<std::list<int>> lruLists; 
-    std::vector<std::unordered_map<int, std::list<int>::iterator>> lruMaps;
-    void initFIFO();
-    void initLRU();
+    bool lastPrefetchHit = false;
+    bool lastVictimValid = false;
+    uint64_t lastVictimBlock = 0;
+    PrefetchStats prefetch;
+    struct MissShadow {
+        MissTypes types;
+        std::list<uint64_t> lru; // blocks, MRU at front
+        std::unordered_map<uint64_t, std::list<uint64_t>::iterator> where;
+        std::unordered_set<uint64_t> seen;
+    };
+    std::unique_ptr<MissShadow> missShadow;
+    // blocks displaced by prefetch fills, for pollution accounting
+    std::unordered_set<uint64_t> prefetchVictims;
+    stats::Counter *statHits = nullptr;
+    stats::Counter *statMisses = nullptr;
+    stats::Counter *statEvictions = nullptr;
+    stats::Counter *statDirtyEvictions = nullptr;
+    stats::CounterArray *statSetMisses = nullptr;
+    // misses that had to replace a valid line (capacity + conflict)
+    stats::CounterArray *statSetConflictMisses = nullptr;
+    stats::Counter *statPrefetchFills = nullptr;
+    stats::Counter *statPrefetchUseful = nullptr;
+    stats::Counter *statPrefetchPollution = nullptr;
+    CacheSet &materialize(uint64_t setIndex);
     DecodedAddress decodeAddress(uint64_t physicalAddress) const;
-    void updatePolicyOnHit(int setIndex, int lineIndex);
-    void updatePolicyOnReplace(int setIndex, int lineIndex);
-    int getVictimIndex(int setIndex);
+    void updatePolicyOnHit(CacheSet &set, int lineIndex);
+    void updatePolicyOnReplace(CacheSet &set, int lineIndex);
+    int getVictimIndex(CacheSet &set);
+    void onDemandHit(CacheLine &line);
+    void classify(uint64_t physicalAddress, bool hit);
+    void onDemandMiss(uint64_t physicalAddress);
+    void onReplace(const CacheLine &victim);
 };
 class cacheHierarchy{
     public:
     cacheHierarchy(Cache *c1 , Cache*c2);
     void stats();
+    // Cycle model used by stats(): L1 1, L2 10, RAM 100
+    double missPenalty() const;
+    double averageAccessTime() const;
     void access(uint64_t physicalAddress,bool write);
+    // Same result as access() on each address in order. Without prefetchers,
+    // victim cache or MSHRs, L1 takes the whole block and L2 its misses.
+    void accessBatch(const uint64_t *physicalAddresses, const bool *writes, size_t count);
+    // Tag-only update of L1/L2; prefetchers, victim cache and MSHRs are bypassed
+    void warm(uint64_t physicalAddress, bool write);
+    void registerStats(stats::Registry &registry);
+    // level 1 or 2; a null prefetcher detaches. Prefetches land `latency` accesses later.
+    void attachPrefetcher(int level, std::unique_ptr<Prefetcher> prefetcher, uint64_t latency);
+    // 0 entries detaches either structure
+    void attachVictimCache(size_t entries);
+    void attachMSHR(size_t entries, uint64_t latency);
     private:
+    struct PrefetchPort {
+        std::unique_ptr<Prefetcher> prefetcher;
+        uint64_t latency = 0;
+        std::deque<std::pair<uint64_t, uint64_t>> inFlight; // (block, ready tick)
+        std::unordered_set<uint64_t> inFlightBlocks;
+        std::vector<uint64_t> candidates;
+        uint64_t issued = 0;
+        uint64_t late = 0;      // demand arrived while the prefetch was in flight
+        uint64_t redundant = 0; // candidate already cached or in flight
+    };
+    void trainPrefetcher(PrefetchPort &port, Cache *cache, uint64_t physicalAddress, bool hit);
+    void drainPrefetches(PrefetchPort &port, Cache *cache);
+    void printPrefetchStats(const char *name, const PrefetchPort &port, const Cache *cache) const;
     Cache *l1Cache;
     Cache *l2Cache;
+    uint64_t tick = 0;
+    PrefetchPort ports[2];
+    std::unique_ptr<VictimCache> victimCache;
+    std::unique_ptr<MSHRFile> mshr;
 };
\ No newline at end of file
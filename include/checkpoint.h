@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <type_traits>
+
+// Versioned binary snapshot of simulator state.
+//
+// File layout: 8-byte magic "MSIMCKPT", uint32 format version, uint32 kind
+// (which CLI mode wrote it), then the components' state in the order the
+// mode saved them. Values are stored little-endian in host layout, so a
+// checkpoint is only portable between hosts of the same endianness.
+//
+// Loading memory-maps the file and decodes straight out of the mapping.
+
+enum class CheckpointKind : uint32_t
+{
+    Allocator = 1,
+    Cache = 2,
+    VirtualMemory = 3,
+    Integrated = 4,
+};
+
+const char *checkpointKindName(CheckpointKind kind);
+
+class CheckpointWriter
+{
+public:
+    template <typename T>
+    void put(const T &value)
+    {
+        static_assert(std::is_arithmetic<T>::value, "checkpoint fields must be scalars");
+        const char *p = reinterpret_cast<const char *>(&value);
+        buffer.insert(buffer.end(), p, p + sizeof(T));
+    }
+    bool writeFile(const std::string &path, CheckpointKind kind) const;
+
+private:
+    std::vector<char> buffer;
+};
+
+class CheckpointReader
+{
+public:
+    CheckpointReader() = default;
+    ~CheckpointReader();
+    CheckpointReader(const CheckpointReader &) = delete;
+    CheckpointReader &operator=(const CheckpointReader &) = delete;
+
+    // Maps the file and validates the header; error() explains a failure
+    bool open(const std::string &path);
+    CheckpointKind kind() const;
+
+    template <typename T>
+    T get()
+    {
+        static_assert(std::is_arithmetic<T>::value, "checkpoint fields must be scalars");
+        T value = T();
+        if (failed || size - pos < sizeof(T))
+        {
+            fail("truncated checkpoint");
+            return value;
+        }
+        std::memcpy(&value, data + pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+    // Reads an element count, rejecting counts the remaining bytes cannot hold
+    uint64_t getCount(size_t minElementSize);
+    size_t remaining() const;
+
+    bool ok() const;
+    const std::string &error() const;
+    void fail(const std::string &message);
+
+private:
+    const char *data = nullptr;
+    size_t size = 0;
+    size_t pos = 0;
+    bool mapped = false;
+    bool failed = false;
+    std::string message;
+    std::vector<char> fallback; // used where mmap is unavailable
+    CheckpointKind fileKind = CheckpointKind::Allocator;
+};
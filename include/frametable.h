@@ -0,0 +1,105 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Physical frame number. Signed so -1 can mean "no frame"; 63 bits cover any
+// RAM size a size_t can describe.
+using FrameNumber = int64_t;
+
+// Per-frame records in fixed-size chunks that are allocated on first write,
+// so memory follows the frames a run actually touches rather than the RAM
+// size. Reads of untouched frames return a default-constructed record
+// without allocating. Only the chunk directory (one pointer per 4096 frames)
+// is sized up front.
+template <typename T>
+class FrameTable
+{
+public:
+    static constexpr size_t CHUNK = 4096;
+
+    explicit FrameTable(size_t count = 0)
+    {
+        reset(count);
+    }
+
+    // Drops every record; the table then covers count frames
+    void reset(size_t count)
+    {
+        chunks.clear();
+        chunks.resize((count + CHUNK - 1) / CHUNK);
+        length = count;
+    }
+
+    T &operator[](size_t frame)
+    {
+        std::unique_ptr<T[]> &chunk = chunks[frame / CHUNK];
+        if (!chunk)
+        {
+            chunk.reset(new T[CHUNK]());
+        }
+        return chunk[frame % CHUNK];
+    }
+
+    T operator[](size_t frame) const
+    {
+        const std::unique_ptr<T[]> &chunk = chunks[frame / CHUNK];
+        return chunk ? chunk[frame % CHUNK] : T();
+    }
+
+    // Host-cache hint for an upcoming access; untouched frames are skipped
+    void prefetch(size_t frame) const
+    {
+        const std::unique_ptr<T[]> &chunk = chunks[frame / CHUNK];
+        if (chunk)
+            __builtin_prefetch(&chunk[frame % CHUNK]);
+    }
+
+    // fn(frame, record) for every record in an allocated chunk, in frame order
+    template <typename Fn>
+    void forEach(Fn fn)
+    {
+        for (size_t c = 0; c < chunks.size(); c++)
+        {
+            if (!chunks[c])
+                continue;
+            size_t end = std::min(CHUNK, length - c * CHUNK);
+            for (size_t i = 0; i < end; i++)
+                fn(c * CHUNK + i, chunks[c][i]);
+        }
+    }
+
+    template <typename Fn>
+    void forEach(Fn fn) const
+    {
+        for (size_t c = 0; c < chunks.size(); c++)
+        {
+            if (!chunks[c])
+                continue;
+            size_t end = std::min(CHUNK, length - c * CHUNK);
+            for (size_t i = 0; i < end; i++)
+                fn(c * CHUNK + i, static_cast<const T &>(chunks[c][i]));
+        }
+    }
+
+    size_t size() const
+    {
+        return length;
+    }
+
+    // Records that exist, whole chunks at a time
+    size_t allocatedRecords() const
+    {
+        size_t count = 0;
+        for (const auto &chunk : chunks)
+            count += chunk != nullptr;
+        return std::min(length, count * CHUNK);
+    }
+
+private:
+    std::vector<std::unique_ptr<T[]>> chunks;
+    size_t length = 0;
+};
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <memory>
+#include <istream>
+
+#include "trace.h"
+
+// Synthetic address streams, produced on the fly. Every generator emits
+// exactly `count` records and is deterministic for a given seed.
+
+// xorshift64* PRNG: a few instructions per draw, good enough for workloads
+class FastRandom
+{
+public:
+    explicit FastRandom(uint64_t seed) : state(seed ? seed : 0x9E3779B97F4A7C15ULL) {}
+    uint64_t next()
+    {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1DULL;
+    }
+    // Uniform in [0, bound)
+    uint64_t below(uint64_t bound) { return next() % bound; }
+    // Uniform in [0, 1)
+    double unit() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+
+private:
+    uint64_t state;
+};
+
+class Generator : public TraceSource
+{
+public:
+    Generator(uint64_t count, int writePercent, uint64_t seed);
+    bool next(TraceRecord &rec) override;
+    void setPid(int pid);
+
+protected:
+    // Next address; may override the random read/write choice
+    virtual uint64_t nextAddress(bool &write) = 0;
+    FastRandom rng;
+
+private:
+    uint64_t remaining;
+    int writePercent;
+    int pid = 0;
+};
+
+// base, base + stride, ... wrapping within footprint bytes
+class SequentialGenerator : public Generator
+{
+public:
+    SequentialGenerator(uint64_t count, uint64_t stride, uint64_t footprint, int writePercent);
+
+protected:
+    uint64_t nextAddress(bool &write) override;
+
+private:
+    uint64_t stride, footprint, pos = 0;
+};
+
+// Uniformly random addresses in [0, footprint), aligned to `align` bytes
+class UniformGenerator : public Generator
+{
+public:
+    UniformGenerator(uint64_t count, uint64_t footprint, uint64_t align, int writePercent, uint64_t seed);
+
+protected:
+    uint64_t nextAddress(bool &write) override;
+
+private:
+    uint64_t slots, align;
+};
+
+// Zipf-distributed item ranks (item 0 hottest) using the constant-time
+// method of Gray et al. (as in YCSB); setup is O(items). theta in (0, 1).
+class ZipfGenerator : public Generator
+{
+public:
+    ZipfGenerator(uint64_t count, uint64_t items, double theta, uint64_t itemSize, int writePercent, uint64_t seed);
+
+protected:
+    uint64_t nextAddress(bool &write) override;
+
+private:
+    uint64_t items, itemSize;
+    double theta, zetan, alpha, eta, halfPowTheta;
+};
+
+// Walks a random single-cycle permutation of nodes: every access depends on
+// the previous one and there is no spatial locality between nodes
+class PointerChaseGenerator : public Generator
+{
+public:
+    PointerChaseGenerator(uint64_t count, uint64_t nodes, uint64_t nodeSize, uint64_t seed);
+
+protected:
+    uint64_t nextAddress(bool &write) override;
+
+private:
+    std::vector<uint64_t> successor;
+    uint64_t nodeSize, current = 0;
+};
+
+// Tiled C += A * B on n x n matrices laid out row-major one after another.
+// For each (i, j) of a tile: read C[i][j], read A[i][k] and B[k][j] across
+// the k tile, write C[i][j]. Restarts once the product is complete.
+class MatMulGenerator : public Generator
+{
+public:
+    MatMulGenerator(uint64_t count, uint64_t n, uint64_t tile, uint64_t elemSize);
+
+protected:
+    uint64_t nextAddress(bool &write) override;
+
+private:
+    uint64_t element(uint64_t matrix, uint64_t row, uint64_t col) const;
+    void advance();
+
+    uint64_t n, tile, elemSize;
+    uint64_t ii = 0, jj = 0, kk = 0, i = 0, j = 0;
+    uint64_t step = 0; // 0: load C, 1..2t: A/B pairs, 2t+1: store C
+};
+
+// A hot set of `hot` bytes hit uniformly hotPercent% of the time; the other
+// accesses sweep a `scan`-byte region above it in `stride`-byte steps,
+// wrapping. With a page-sized stride every scanned page is used once: the
+// classic workload where LRU and FIFO let the scan flush the hot pages.
+class ScanHotGenerator : public Generator
+{
+public:
+    ScanHotGenerator(uint64_t count, uint64_t hot, uint64_t scan, uint64_t stride, int hotPercent, uint64_t seed);
+
+protected:
+    uint64_t nextAddress(bool &write) override;
+
+private:
+    uint64_t hot, scan, stride, pos = 0;
+    int hotPercent;
+};
+
+// Interleaves one stream per pid (1..pids) in bursts of `burst` accesses
+class MixGenerator : public TraceSource
+{
+public:
+    MixGenerator(std::vector<std::unique_ptr<Generator>> streams, uint64_t burst);
+    bool next(TraceRecord &rec) override;
+
+private:
+    std::vector<std::unique_ptr<Generator>> streams;
+    uint64_t burst, inBurst = 0;
+    size_t current = 0;
+};
+
+// Parses "<kind> <count> <params...>" (see README); nullptr with a usage
+// message in error if the arguments are invalid
+std::unique_ptr<TraceSource> makeGenerator(std::istream &args, std::string &error);
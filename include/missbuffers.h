@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <list>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+
+// Small structures that sit between L1 and L2 and absorb L1 misses before
+// they reach L2. Both work on block-aligned addresses.
+
+// Fully-associative LRU buffer holding lines recently evicted from L1
+class VictimCache
+{
+public:
+    explicit VictimCache(size_t entries);
+    // On a hit the block leaves the victim cache (it moves back into L1)
+    bool extract(uint64_t block);
+    // Line displaced from L1
+    void insert(uint64_t block);
+    size_t capacity() const;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+
+private:
+    size_t numEntries;
+    std::list<uint64_t> lruList; // MRU at front
+    std::unordered_map<uint64_t, std::list<uint64_t>::iterator> lruMap;
+};
+
+// Miss status holding registers. Each primary L1 miss to L2 occupies an entry
+// for `latency` accesses; later misses to the same block merge into it
+// instead of issuing another L2 request.
+class MSHRFile
+{
+public:
+    MSHRFile(size_t entries, uint64_t latency);
+    // True if the block already has an outstanding miss (request merged)
+    bool merge(uint64_t block, uint64_t now);
+    // Registers a primary miss, stalling until an entry frees up if all are busy
+    void allocate(uint64_t block, uint64_t now);
+    size_t capacity() const;
+    uint64_t getLatency() const;
+    uint64_t primary = 0;
+    uint64_t merged = 0;
+    uint64_t stalls = 0;
+    uint64_t stallCycles = 0;
+    size_t peakOccupancy = 0;
+
+private:
+    void retire(uint64_t now);
+    size_t numEntries;
+    uint64_t latency;
+    // (block, ready tick); latency is fixed so ready ticks are ordered
+    std::deque<std::pair<uint64_t, uint64_t>> outstanding;
+    std::unordered_set<uint64_t> outstandingBlocks;
+};
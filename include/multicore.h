@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include "cache.h"
+
+// Multi-core cache model: private L1 per core, one shared L2, and a MESI
+// directory tracking which cores hold each block.
+//
+// Each core's trace runs on its own host thread. Time advances in quanta:
+// during a quantum every core services, in parallel, the L1 hits that need no
+// coherence action (reads, writes to lines held in M) and queues everything
+// else. At the quantum barrier the queued requests are applied on one thread,
+// interleaved round-robin across cores, so results are deterministic for a
+// given quantum.
+class MultiCoreSystem
+{
+public:
+    MultiCoreSystem(int cores, size_t l1Size, size_t l2Size, size_t blockSize, int associativity, uint64_t quantum);
+    void addAccess(int core, uint64_t physicalAddress, bool write);
+    // Simulates every buffered access, then clears the per-core traces
+    void run();
+    void stats() const;
+    int numCores() const;
+    size_t pending() const;
+
+private:
+    enum class Request
+    {
+        Read,  // L1 read miss
+        Write, // write to a line this core does not hold in M
+    };
+    struct TraceEntry
+    {
+        uint64_t addr;
+        bool write;
+    };
+    struct QueuedRequest
+    {
+        Request type;
+        uint64_t addr;
+    };
+    struct DirEntry
+    {
+        uint64_t sharers = 0; // bitmask of cores holding the block
+        int owner = -1;       // core in E or M
+        bool dirty = false;   // owner is in M
+    };
+    struct CoreState
+    {
+        std::unique_ptr<Cache> l1;
+        std::vector<TraceEntry> trace;
+        size_t next = 0;
+        std::vector<QueuedRequest> queued;
+        uint64_t accesses = 0;
+        uint64_t upgrades = 0;
+    };
+
+    class Barrier
+    {
+    public:
+        explicit Barrier(int parties);
+        void wait();
+
+    private:
+        std::mutex mtx;
+        std::condition_variable cv;
+        int parties;
+        int waiting = 0;
+        uint64_t generation = 0;
+    };
+
+    void runQuantum(int core);
+    void applyQueued();
+    void handleRead(int core, uint64_t addr);
+    void handleWrite(int core, uint64_t addr);
+    // take the block in M, invalidating every other copy
+    void claimExclusive(int core, uint64_t addr, bool hadCopy);
+    void recordEviction(int core);
+    uint64_t blockOf(uint64_t addr) const;
+
+    std::vector<CoreState> cores;
+    std::unique_ptr<Cache> l2;
+    std::unordered_map<uint64_t, DirEntry> directory;
+    size_t blockSize;
+    uint64_t quantum;
+    uint64_t quantaRun = 0;
+
+    // coherence traffic
+    uint64_t invalidations = 0;   // copies invalidated by another core's write
+    uint64_t downgrades = 0;      // E/M -> S on a remote read
+    uint64_t writebacks = 0;      // dirty lines written back to L2
+    uint64_t peerTransfers = 0;   // misses served by another core's M/E copy
+    uint64_t upgradeRequests = 0; // S -> M upgrades
+    uint64_t directoryLookups = 0;
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+#include <unordered_map>
+
+#include "trace.h"
+#include "sweep.h"
+
+// Offline Belady OPT/MIN: evict the resident item whose next use lies
+// furthest in the future. Next uses come from a backward pass over the
+// recorded stream.
+
+// Records a key stream and annotates each position with the position of the
+// key's next occurrence (NEVER if none). Streams longer than one chunk are
+// spilled to temporary files and the backward pass walks them chunk by
+// chunk, so memory is one chunk plus one entry per distinct key.
+class NextUseTable
+{
+public:
+    static constexpr uint64_t NEVER = UINT64_MAX;
+
+    explicit NextUseTable(size_t chunkRecords = 1 << 20);
+    ~NextUseTable();
+    NextUseTable(const NextUseTable &) = delete;
+    NextUseTable &operator=(const NextUseTable &) = delete;
+
+    void append(uint64_t key);
+    // Runs the backward pass; false if a temporary file could not be used
+    bool finalize();
+    // Replays the stream in order after finalize()
+    bool next(uint64_t &key, uint64_t &nextUse);
+    uint64_t size() const;
+
+private:
+    bool spill();
+    bool loadChunk(uint64_t chunk);
+
+    size_t chunkRecords;
+    std::vector<uint64_t> keys;
+    std::vector<uint64_t> nextUses;
+    std::FILE *keyFile = nullptr;
+    std::FILE *nextFile = nullptr;
+    uint64_t total = 0;
+    uint64_t readPos = 0;
+    size_t bufferPos = 0;
+    bool failed = false;
+};
+
+// Set-associative (or, with one set, fully associative) OPT store. Each set
+// keeps a max-heap on next use with lazy deletion: re-referenced items push
+// a fresh entry and stale ones are discarded when they surface.
+class OptCache
+{
+public:
+    OptCache(size_t sets, size_t ways);
+    // True on hit; on a miss the item is installed, evicting if the set is full
+    bool access(uint64_t key, uint64_t nextUse);
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+
+private:
+    struct Set
+    {
+        std::unordered_map<uint64_t, uint64_t> resident; // key -> next use
+        std::vector<std::pair<uint64_t, uint64_t>> heap; // (next use, key)
+    };
+    void compact(Set &set);
+
+    std::vector<Set> sets;
+    size_t ways;
+};
+
+struct OptReport
+{
+    uint64_t accesses = 0;
+    uint64_t l1Misses = 0, l1OptMisses = 0;
+    uint64_t l2Misses = 0, l2OptMisses = 0;
+    uint64_t faults = 0, optFaults = 0;
+    bool ok = true;
+};
+
+// Replays the trace on a fresh system built from config, then re-runs the
+// same reference streams under OPT: frames on the (pid, page) stream, L1 on
+// the physical block stream, L2 on the L1-OPT miss stream.
+OptReport compareWithOpt(const SweepConfig &config, TraceSource &source, size_t chunkRecords = 1 << 20);
+void printOptReport(const OptReport &report, const SweepConfig &config);
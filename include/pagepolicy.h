@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <list>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <functional>
+#include "frametable.h"
+
+// Page replacement policies selectable at init. FIFO and LRU are built into
+// PhysicalMemory; the scan-resistant ones below plug in through PagePolicy.
+enum class ReplacementKind
+{
+    FIFO = 0,
+    LRU = 1,
+    ARC = 2,
+    TwoQ = 3,
+    LFU = 4
+};
+
+const char *replacementName(ReplacementKind kind);
+
+// Identity of a virtual page, used by policies that remember evicted pages
+struct PageId
+{
+    int pid = -1;
+    uint64_t vpn = 0;
+    bool operator==(const PageId &o) const { return pid == o.pid && vpn == o.vpn; }
+};
+
+struct PageIdHash
+{
+    size_t operator()(const PageId &p) const
+    {
+        return std::hash<uint64_t>()(p.vpn * 0x9E3779B97F4A7C15ULL ^ (uint64_t)(uint32_t)p.pid);
+    }
+};
+
+// Frame-level replacement state. Every operation is O(1) (amortized for the
+// hash lookups); PhysicalMemory calls victim() only when no frame is free.
+class PagePolicy
+{
+public:
+    explicit PagePolicy(size_t frames);
+    virtual ~PagePolicy() = default;
+    // frame now holds page after a fault
+    virtual void fill(FrameNumber frame, const PageId &page) = 0;
+    // hit on a resident frame
+    virtual void touch(FrameNumber frame) = 0;
+    // chooses and forgets the frame to reuse for incoming
+    virtual FrameNumber victim(const PageId &incoming) = 0;
+    // page migration: the page in `from` now lives in `to`; with exchange the
+    // page that was in `to` moved the other way, otherwise `to` was free
+    virtual void relocate(FrameNumber from, FrameNumber to, bool exchange) = 0;
+    // frame was freed (its process exited)
+    virtual void remove(FrameNumber frame) = 0;
+    virtual const char *name() const = 0;
+
+protected:
+    size_t frames;
+};
+
+// Moves per-frame bookkeeping along with a migrated page. Every policy keeps
+// a frame table of records holding an iterator to the frame's list node.
+template <typename Record>
+void relocateRecord(FrameTable<Record> &records, FrameNumber from, FrameNumber to, bool exchange)
+{
+    if (exchange)
+    {
+        std::swap(records[from], records[to]);
+        *records[from].pos = from;
+    }
+    else
+    {
+        records[to] = records[from];
+    }
+    *records[to].pos = to;
+}
+
+// nullptr for FIFO and LRU, which PhysicalMemory handles itself
+std::unique_ptr<PagePolicy> makePagePolicy(ReplacementKind kind, size_t frames);
+
+// Adaptive Replacement Cache (Megiddo & Modha): recency list T1 and frequency
+// list T2, with ghost lists B1/B2 of recently evicted pages steering the
+// target size p of T1
+class ArcPolicy : public PagePolicy
+{
+public:
+    explicit ArcPolicy(size_t frames);
+    void fill(FrameNumber frame, const PageId &page) override;
+    void touch(FrameNumber frame) override;
+    FrameNumber victim(const PageId &incoming) override;
+    void relocate(FrameNumber from, FrameNumber to, bool exchange) override;
+    void remove(FrameNumber frame) override;
+    const char *name() const override { return "ARC"; }
+
+private:
+    struct Resident
+    {
+        PageId page;
+        bool inT2 = false;
+        std::list<FrameNumber>::iterator pos;
+    };
+    struct Ghost
+    {
+        bool inB2 = false;
+        std::list<PageId>::iterator pos;
+    };
+    std::list<FrameNumber> t1, t2; // resident frames, MRU at front
+    std::list<PageId> b1, b2;      // evicted pages, MRU at front
+    FrameTable<Resident> resident;
+    std::unordered_map<PageId, Ghost, PageIdHash> ghosts;
+    size_t p = 0;  // target size of T1
+    bool decided = false;  // victim() already ran the miss logic for the next fill
+    bool fillT2 = false;
+
+    bool admit(const PageId &page);
+    FrameNumber replace(bool ghostInB2);
+    void dropGhost(std::list<PageId> &list);
+    void addGhost(const PageId &page, bool toB2);
+};
+
+// Full 2Q (Johnson & Shasha): first-time pages enter the FIFO A1in; pages
+// evicted from it are remembered in A1out and promoted to the LRU Am if they
+// fault again
+class TwoQPolicy : public PagePolicy
+{
+public:
+    explicit TwoQPolicy(size_t frames);
+    void fill(FrameNumber frame, const PageId &page) override;
+    void touch(FrameNumber frame) override;
+    FrameNumber victim(const PageId &incoming) override;
+    void relocate(FrameNumber from, FrameNumber to, bool exchange) override;
+    void remove(FrameNumber frame) override;
+    const char *name() const override { return "2Q"; }
+
+private:
+    struct Resident
+    {
+        PageId page;
+        bool inAm = false;
+        std::list<FrameNumber>::iterator pos;
+    };
+    std::list<FrameNumber> a1in, am;  // newest / MRU at front
+    std::list<PageId> a1out;
+    std::unordered_map<PageId, std::list<PageId>::iterator, PageIdHash> a1outMap;
+    FrameTable<Resident> resident;
+    size_t kin, kout;
+};
+
+// LFU with dynamic aging (LFU-DA): a page's key is its hit count plus the
+// key of the last victim at the time it was loaded, so stale popular pages
+// eventually lose to new ones. Keys only step by one, which keeps the
+// frequency-bucket list O(1) per access.
+class LfuPolicy : public PagePolicy
+{
+public:
+    explicit LfuPolicy(size_t frames);
+    void fill(FrameNumber frame, const PageId &page) override;
+    void touch(FrameNumber frame) override;
+    FrameNumber victim(const PageId &incoming) override;
+    void relocate(FrameNumber from, FrameNumber to, bool exchange) override;
+    void remove(FrameNumber frame) override;
+    const char *name() const override { return "LFU"; }
+
+private:
+    struct Bucket
+    {
+        uint64_t key;
+        std::list<FrameNumber> frames;  // MRU at front; ties evict from the back
+    };
+    struct Resident
+    {
+        std::list<Bucket>::iterator bucket;
+        std::list<FrameNumber>::iterator pos;
+    };
+    std::list<Bucket> buckets;  // ascending key
+    FrameTable<Resident> resident;
+    uint64_t age = 0;
+
+    void place(FrameNumber frame, std::list<Bucket>::iterator bucket);
+    void unlink(FrameNumber frame);
+};
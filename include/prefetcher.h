@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <memory>
+#include <string>
+
+// Hardware prefetcher models. A prefetcher watches the demand stream of the
+// cache level it is attached to and proposes block-aligned addresses to fetch
+// ahead of use; cacheHierarchy issues and accounts for them.
+class Prefetcher
+{
+public:
+    Prefetcher(size_t blockSize, int degree);
+    virtual ~Prefetcher() = default;
+    // prefetchHit: the access hit a line that an earlier prefetch brought in
+    virtual void observe(uint64_t blockAddr, bool hit, bool prefetchHit, std::vector<uint64_t> &out) = 0;
+    virtual const char *name() const = 0;
+
+protected:
+    size_t blockSize;
+    int degree;
+};
+
+// kind: "next", "stride" or "corr"; nullptr for anything else
+std::unique_ptr<Prefetcher> makePrefetcher(const std::string &kind, size_t blockSize, int degree);
+
+// Tagged next-N-line: triggers on a miss or the first use of a prefetched line
+class NextLinePrefetcher : public Prefetcher
+{
+public:
+    using Prefetcher::Prefetcher;
+    void observe(uint64_t blockAddr, bool hit, bool prefetchHit, std::vector<uint64_t> &out) override;
+    const char *name() const override { return "next-line"; }
+};
+
+// IP-less stream detector: tracks a few address streams by proximity and
+// prefetches along a stride once it has been seen twice in a row
+class StreamPrefetcher : public Prefetcher
+{
+public:
+    StreamPrefetcher(size_t blockSize, int degree);
+    void observe(uint64_t blockAddr, bool hit, bool prefetchHit, std::vector<uint64_t> &out) override;
+    const char *name() const override { return "stride"; }
+
+private:
+    struct Stream
+    {
+        bool valid = false;
+        uint64_t lastBlock = 0;
+        int64_t stride = 0;
+        int confidence = 0;
+        uint64_t lastUse = 0;
+    };
+    static const int NUM_STREAMS = 16;
+    static const int64_t WINDOW = 16; // blocks
+    std::vector<Stream> streams;
+    uint64_t clock = 0;
+};
+
+// Markov-style correlation table: remembers the two most recent successors of
+// each miss block and prefetches them when the block misses again
+class CorrelationPrefetcher : public Prefetcher
+{
+public:
+    CorrelationPrefetcher(size_t blockSize, int degree);
+    void observe(uint64_t blockAddr, bool hit, bool prefetchHit, std::vector<uint64_t> &out) override;
+    const char *name() const override { return "correlation"; }
+
+private:
+    struct Entry
+    {
+        bool valid = false;
+        uint64_t block = 0;
+        uint64_t next[2] = {0, 0};
+        int count = 0;
+    };
+    static const size_t TABLE_SIZE = 4096;
+    Entry &slot(uint64_t block);
+    std::vector<Entry> table;
+    bool haveLast = false;
+    uint64_t lastBlock = 0;
+};
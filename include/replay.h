@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+#include "trace.h"
+#include "cache.h"
+#include "virtualmemory.h"
+#include "sampler.h"
+
+using ProcessMap = std::unordered_map<int, std::unique_ptr<VirtualMemory>>;
+
+// Integrated-mode system a trace is replayed against
+struct ReplayTarget
+{
+    PhysicalMemory *pm;
+    Cache *l1;
+    Cache *l2;
+    cacheHierarchy *hierarchy;
+    ProcessMap *processes;
+};
+
+// Returns the address space for pid, creating it on first use
+VirtualMemory &processFor(const ReplayTarget &target, int pid);
+
+// Simulates every record in detail; returns the number of accesses replayed
+uint64_t replayTrace(TraceSource &source, const ReplayTarget &target, IntervalSampler *sampler);
+
+// Same results as replayTrace, as a three-stage pipeline: one thread reads
+// and decodes records, one translates them, and the caller's thread runs the
+// caches. Stages hand records on in batches through SPSC rings, so order is
+// kept. Paging and cache state never feed back into each other, which makes
+// the overlap safe; a sampler would read both mid-flight, so there is none.
+uint64_t replayPipelined(TraceSource &source, const ReplayTarget &target);
+
+// Periodic sampling: every `period` accesses, the last `window` are simulated
+// in detail. Before each window, `warmup` accesses are functionally warmed
+// (tags and page tables only, no statistics); anything earlier in the period
+// is skipped outright. warmup == ALL_WARMUP warms the whole gap instead, which
+// keeps cache/TLB state exact at the cost of touching every access.
+struct SamplingConfig
+{
+    static constexpr uint64_t ALL_WARMUP = UINT64_MAX;
+    uint64_t period = 0;
+    uint64_t window = 0;
+    uint64_t warmup = ALL_WARMUP;
+    bool enabled() const { return period > 0; }
+};
+
+// Running mean/variance of one per-window metric (Welford)
+class SampleStats
+{
+public:
+    void add(double value);
+    uint64_t count() const { return n; }
+    double mean() const { return avg; }
+    double stddev() const;
+    // Half-width of the 95% confidence interval of the mean (normal approx.)
+    double ci95() const;
+
+private:
+    uint64_t n = 0;
+    double avg = 0.0;
+    double m2 = 0.0;
+};
+
+struct SampledResult
+{
+    uint64_t total = 0;    // records read from the trace
+    uint64_t detailed = 0; // simulated in detail
+    uint64_t warmed = 0;   // functionally warmed
+    SampleStats l1MissRate;
+    SampleStats l2MissRate; // local to L2
+    SampleStats faultRate;
+};
+
+SampledResult replaySampled(TraceSource &source, const ReplayTarget &target, const SamplingConfig &config);
+void printSampled(const SampledResult &result, const SamplingConfig &config);
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Bounded single-producer/single-consumer queue. Head and tail live on
+// separate cache lines; each side only writes its own index, so no locks are
+// needed. Blocking calls spin with yield, which suits pipelines where both
+// threads are busy most of the time.
+template <typename T>
+class SpscRing
+{
+public:
+    // Capacity is rounded up to a power of two
+    explicit SpscRing(size_t capacity)
+    {
+        size_t cap = 2;
+        while (cap < capacity)
+            cap <<= 1;
+        slots.resize(cap);
+        mask = cap - 1;
+    }
+
+    // Blocks while full; returns false if the consumer cancelled
+    bool push(const T &item)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        while (t - head.load(std::memory_order_acquire) > mask)
+        {
+            if (cancelled.load(std::memory_order_relaxed))
+                return false;
+            std::this_thread::yield();
+        }
+        slots[t & mask] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Pushes all n items, publishing as many at a time as there is room
+    // for. Blocks while full; returns false if the consumer cancelled.
+    bool pushBatch(const T *items, size_t n)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        while (n > 0)
+        {
+            size_t room;
+            while ((room = mask + 1 - (t - head.load(std::memory_order_acquire))) == 0)
+            {
+                if (cancelled.load(std::memory_order_relaxed))
+                    return false;
+                std::this_thread::yield();
+            }
+            size_t k = n < room ? n : room;
+            for (size_t i = 0; i < k; i++)
+                slots[(t + i) & mask] = items[i];
+            t += k;
+            items += k;
+            n -= k;
+            tail.store(t, std::memory_order_release);
+        }
+        return true;
+    }
+
+    // Moves up to max items into out, blocking until at least one is
+    // available. Returns 0 only once the producer has closed and the ring is
+    // drained.
+    size_t popBatch(T *out, size_t max)
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t t;
+        while ((t = tail.load(std::memory_order_acquire)) == h)
+        {
+            if (closed.load(std::memory_order_acquire))
+            {
+                // the producer may have pushed right before closing
+                t = tail.load(std::memory_order_acquire);
+                if (t == h)
+                    return 0;
+                break;
+            }
+            std::this_thread::yield();
+        }
+        size_t n = t - h < max ? t - h : max;
+        for (size_t i = 0; i < n; i++)
+            out[i] = slots[(h + i) & mask];
+        head.store(h + n, std::memory_order_release);
+        return n;
+    }
+
+    // Producer: no more items will be pushed
+    void close() { closed.store(true, std::memory_order_release); }
+    // Consumer: stop waiting producers
+    void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+
+private:
+    std::vector<T> slots;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+    alignas(64) std::atomic<bool> closed{false};
+    std::atomic<bool> cancelled{false};
+};
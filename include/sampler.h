@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <functional>
+#include <fstream>
+#include <ostream>
+
+// Streams a CSV row of metric snapshots every `interval` simulated events
+// (accesses or allocator operations). Rates are computed over the window since
+// the previous row, so warm-up and phase changes show up directly.
+class IntervalSampler
+{
+public:
+    // path "-" streams to stdout
+    IntervalSampler(const std::string &path, uint64_t interval);
+    ~IntervalSampler();
+    bool isOpen() const;
+
+    // Point-in-time value (e.g. frames in use, ext_frag)
+    void addGauge(const std::string &name, std::function<double()> fn);
+    // Windowed ratio: delta(numerator) / delta(denominator) since the last row
+    void addRate(const std::string &name, std::function<uint64_t()> numerator,
+                 std::function<uint64_t()> denominator);
+
+    void tick()
+    {
+        if (++events >= nextSample)
+            sample();
+    }
+    // Emit a final row for a partially filled window
+    void finish();
+
+private:
+    struct Rate
+    {
+        std::string name;
+        std::function<uint64_t()> numerator;
+        std::function<uint64_t()> denominator;
+        uint64_t lastNumerator = 0;
+        uint64_t lastDenominator = 0;
+    };
+    struct GaugeColumn
+    {
+        std::string name;
+        std::function<double()> fn;
+    };
+
+    void sample();
+
+    std::ofstream file;
+    std::ostream *out;
+    uint64_t interval;
+    uint64_t events = 0;
+    uint64_t lastSampled = 0;
+    uint64_t nextSample;
+    bool headerWritten = false;
+    std::vector<Rate> rates;
+    std::vector<GaugeColumn> gauges;
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "pagepolicy.h"
+
+// Binary indexed tree of counts, used to count marked timestamps in a range
+class FenwickTree
+{
+public:
+    explicit FenwickTree(size_t size = 0);
+    void add(size_t index, int64_t delta);
+    // sum of [0, index]
+    int64_t prefix(size_t index) const;
+    size_t size() const;
+
+private:
+    std::vector<int64_t> tree;
+};
+
+// Mattson's LRU stack distances for one reference stream. The distance of a
+// reference is the number of distinct pages touched since the previous
+// reference to the same page, itself included, so an LRU memory with F frames
+// hits exactly the references with distance <= F. Each page's latest
+// timestamp is marked in a Fenwick tree, which makes a reference O(log n);
+// timestamps are renumbered when the tree fills, keeping memory
+// proportional to the number of distinct pages.
+class StackDistance
+{
+public:
+    StackDistance();
+    // Returns the distance, or 0 for a page's first reference
+    uint64_t reference(const PageId &page);
+    // LRU faults this stream would take with the given number of frames
+    uint64_t faults(size_t frames) const;
+    uint64_t references() const;
+    uint64_t coldFaults() const;
+    size_t distinctPages() const;
+    // references per distance; index 0 is unused
+    const std::vector<uint64_t> &distances() const;
+
+private:
+    void compact();
+
+    std::unordered_map<PageId, uint64_t, PageIdHash> lastUse; // page -> timestamp
+    FenwickTree marks;
+    uint64_t now = 0;
+    uint64_t total = 0;
+    uint64_t cold = 0;
+    std::vector<uint64_t> histogram; // index = distance
+};
+
+// Faults-versus-frames curves for a paging run, filled from the references
+// VirtualMemory translates. The global LRU curve covers every (pid, vpn) and
+// matches the simulator's LRU replacement for every frame count at once;
+// each process also gets its own curve as if it had the memory to itself.
+// FIFO has no inclusion property, so it is simulated directly at each power
+// of two up to maxFrames (the RAM sizes init accepts) instead.
+class FaultCurve
+{
+public:
+    explicit FaultCurve(size_t maxFrames);
+    void reference(int pid, uint64_t vpn);
+    size_t maxFrames() const;
+    // Table at powers of two, up to the point where only cold faults remain
+    void print(std::ostream &out) const;
+    // Every frame count from 1 to the number of distinct pages
+    void writeCsv(std::ostream &out) const;
+
+private:
+    struct Fifo
+    {
+        size_t frames;
+        std::deque<PageId> queue;
+        std::unordered_set<PageId, PageIdHash> resident;
+        uint64_t faults = 0;
+    };
+
+    size_t limit;
+    StackDistance global;
+    std::map<int, StackDistance> perProcess;
+    std::vector<Fifo> fifo; // frames 1, 2, 4, ... maxFrames
+};
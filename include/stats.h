@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <ostream>
+
+// Central metrics registry.
+// Subsystems fetch handles once in their registerStats() and bump them through
+// the STAT_* macros below; building with -DMEMSIM_NO_STATS compiles every
+// update out. Objects that never register keep null handles and record nothing.
+namespace stats
+{
+    struct Counter
+    {
+        uint64_t value = 0;
+    };
+
+    struct Gauge
+    {
+        double value = 0.0;
+    };
+
+    // Dense counter family indexed by a small integer (e.g. cache set index)
+    struct CounterArray
+    {
+        std::vector<uint64_t> values;
+    };
+
+    // Sparse counter family keyed by an arbitrary integer label (e.g. PID)
+    struct LabeledCounter
+    {
+        std::map<int64_t, uint64_t> values;
+    };
+
+    // Power-of-two buckets: bucket i holds samples whose bit width is i
+    struct Histogram
+    {
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        uint64_t min = 0;
+        uint64_t max = 0;
+        std::vector<uint64_t> buckets = std::vector<uint64_t>(65, 0);
+        void record(uint64_t sample);
+    };
+
+    class Registry
+    {
+    public:
+        // Each call returns the named metric (creating it on first use) reset to
+        // zero, so re-initialising a subsystem starts its metrics fresh. Handles
+        // stay valid for the lifetime of the registry.
+        Counter *counter(const std::string &name);
+        Gauge *gauge(const std::string &name);
+        CounterArray *counterArray(const std::string &name, size_t size);
+        LabeledCounter *labeledCounter(const std::string &name);
+        Histogram *histogram(const std::string &name);
+
+        void writeJSON(std::ostream &os) const;
+        void writeCSV(std::ostream &os) const;
+
+    private:
+        std::map<std::string, std::unique_ptr<Counter>> counters;
+        std::map<std::string, std::unique_ptr<Gauge>> gauges;
+        std::map<std::string, std::unique_ptr<CounterArray>> arrays;
+        std::map<std::string, std::unique_ptr<LabeledCounter>> labeled;
+        std::map<std::string, std::unique_ptr<Histogram>> histograms;
+    };
+
+    // Process-wide registry used by the CLI modes
+    Registry &global();
+}
+
+#ifndef MEMSIM_NO_STATS
+#define STAT_INC(c) do { if (c) (c)->value++; } while (0)
+#define STAT_ADD(c, n) do { if (c) (c)->value += (n); } while (0)
+#define STAT_SET(g, v) do { if (g) (g)->value = (v); } while (0)
+#define STAT_INC_AT(a, i) do { if (a) (a)->values[i]++; } while (0)
+#define STAT_INC_LABEL(l, k) do { if (l) (l)->values[k]++; } while (0)
+#define STAT_RECORD(h, v) do { if (h) (h)->record(v); } while (0)
+#else
+#define STAT_INC(c) ((void)0)
+#define STAT_ADD(c, n) ((void)0)
+#define STAT_SET(g, v) ((void)0)
+#define STAT_INC_AT(a, i) ((void)0)
+#define STAT_INC_LABEL(l, k) ((void)0)
+#define STAT_RECORD(h, v) ((void)0)
+#endif
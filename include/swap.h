@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <queue>
+#include <vector>
+#include <functional>
+
+// Backing store for evicted dirty pages. Up to queueDepth page transfers are
+// in flight at once; a request issued while the queue is full waits for the
+// earliest one to finish. Times are in cycles of the paging clock, which
+// advances one cycle per translated access plus any time spent stalled here.
+class SwapDevice
+{
+public:
+    SwapDevice(uint64_t readLatency, uint64_t writeLatency, size_t queueDepth);
+    // Synchronous page-in issued at now; returns the cycle it completes
+    uint64_t read(uint64_t now);
+    // Posted write-back; returns the cycle the caller may continue, which is
+    // later than now only if it had to wait for a queue slot
+    uint64_t write(uint64_t now);
+    uint64_t getReadLatency() const;
+    uint64_t getWriteLatency() const;
+    size_t getQueueDepth() const;
+    uint64_t reads = 0;
+    uint64_t writes = 0;
+    uint64_t readCycles = 0;  // issue to completion, summed over page-ins
+    uint64_t fullStalls = 0;
+    uint64_t fullStallCycles = 0;
+    size_t peakQueue = 0;
+
+private:
+    uint64_t issue(uint64_t now, uint64_t latency);
+    uint64_t readLatency, writeLatency;
+    size_t queueDepth;
+    // completion cycles of in-flight transfers, earliest on top
+    std::priority_queue<uint64_t, std::vector<uint64_t>, std::greater<uint64_t>> inFlight;
+};
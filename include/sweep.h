@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "trace.h"
+
+// One point of the design space (Integrated-mode init parameters)
+struct SweepConfig
+{
+    size_t ram;
+    size_t page;
+    size_t l1;
+    size_t l2;
+    size_t block;
+    int assoc;
+    bool lru;
+};
+
+struct SweepResult
+{
+    std::string error; // non-empty if the configuration is invalid
+    uint64_t l1Hits = 0, l1Misses = 0;
+    uint64_t l2Hits = 0, l2Misses = 0;
+    uint64_t faults = 0, translations = 0;
+    double aat = 0.0;
+};
+
+// Value lists per parameter; the sweep runs their Cartesian product
+struct SweepGrid
+{
+    std::vector<uint64_t> ram{65536};
+    std::vector<uint64_t> page{4096};
+    std::vector<uint64_t> l1{1024};
+    std::vector<uint64_t> l2{8192};
+    std::vector<uint64_t> block{64};
+    std::vector<uint64_t> assoc{2};
+    std::vector<uint64_t> policy{1}; // 0 = FIFO, 1 = LRU
+
+    // Parameter name -> list; nullptr if unknown
+    std::vector<uint64_t> *param(const std::string &name);
+    std::vector<SweepConfig> expand() const;
+};
+
+// Simulates one configuration on objects private to the calling thread;
+// nothing is registered with the stats registry
+SweepResult runConfig(const SweepConfig &config, const std::vector<TraceRecord> &trace);
+
+// Runs every configuration over the shared, read-only trace on a
+// work-stealing pool; results are in configuration order
+std::vector<SweepResult> runSweep(const std::vector<SweepConfig> &configs, const std::vector<TraceRecord> &trace, unsigned threads);
+
+void printSweep(const std::vector<SweepConfig> &configs, const std::vector<SweepResult> &results);
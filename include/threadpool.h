@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool with one task deque per worker. Submitted tasks are dealt
+// round-robin; a worker runs its own deque newest-first and, when it runs
+// dry, steals the oldest task from a peer, so uneven tasks still balance.
+class WorkStealingPool
+{
+public:
+    // 0 picks the hardware thread count
+    explicit WorkStealingPool(unsigned threads = 0);
+    ~WorkStealingPool();
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    void submit(std::function<void()> task);
+    // Blocks until every submitted task has finished
+    void wait();
+    unsigned size() const;
+
+private:
+    struct TaskQueue
+    {
+        std::mutex mtx;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    bool popLocal(size_t worker, std::function<void()> &task);
+    bool steal(size_t worker, std::function<void()> &task);
+    void workerLoop(size_t worker);
+
+    std::vector<std::unique_ptr<TaskQueue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> queued{0};
+    std::atomic<size_t> unfinished{0};
+    size_t nextQueue = 0;
+    bool stopping = false;
+    std::mutex idleMtx;
+    std::condition_variable idleCv;
+    std::condition_variable doneCv;
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <fstream>
+
+// One memory access from a replayed trace
+struct TraceRecord
+{
+    int pid = 0;
+    uint64_t addr = 0;
+    bool write = false;
+};
+
+// Sequential stream of accesses (trace files, generators)
+class TraceSource
+{
+public:
+    virtual ~TraceSource() = default;
+    // Fills rec and returns true, or returns false at end of stream
+    virtual bool next(TraceRecord &rec) = 0;
+    // Discards the next count records; indexed formats override this to seek
+    virtual void skip(uint64_t count);
+    // Non-empty if the stream ended early because the input was bad
+    virtual std::string error() const;
+};
+
+// Reads accesses out of a memsim command script or a bare text trace.
+// Script lines are interpreted by the mode selected in the menu:
+//   Cache:      access <addr> <0|1>        (pid 0)
+//   VM:         access <pid> <addr> [0|1]  (read unless 1)
+//   Integrated: access <pid> <addr> <0|1>
+// Bare lines are "<pid> <addr> <0|1>" or "<addr> <0|1>"; everything else
+// (init, stats, ...) is skipped.
+class TextTraceSource : public TraceSource
+{
+public:
+    explicit TextTraceSource(const std::string &path);
+    bool isOpen() const;
+    bool next(TraceRecord &rec) override;
+
+private:
+    std::ifstream in;
+    std::string line;
+    int mode = 4;
+    bool atMenu = true;
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <thread>
+#include <unordered_map>
+
+#include "trace.h"
+#include "ringbuffer.h"
+
+// Compact binary trace (.mtr).
+//
+// File layout (all fixed-width fields little-endian):
+//   header   "MSIMTRC1", uint32 version, uint32 records per chunk
+//   chunks   uint32 payload bytes, uint32 record count, payload
+//   index    per chunk: uint64 file offset, uint64 first record number
+//   footer   uint64 index offset, uint64 chunk count, uint64 record count,
+//            "MSIMTIDX"
+//
+// Each record is one varint tag, optionally followed by varints:
+//   bit 0    write
+//   bit 1    pid changed: the new pid follows the tag
+//   bit 2    wide delta: the delta follows the tag (and the pid, if any)
+//   bits 3+  zigzag address delta, when it fits
+// Deltas are taken against the previous address of the same pid, so
+// interleaved processes each keep their own locality. All delta state resets
+// at a chunk boundary; any chunk can be decoded on its own, which is what the
+// index uses to seek.
+
+class BinaryTraceWriter
+{
+public:
+    explicit BinaryTraceWriter(const std::string &path, uint32_t chunkRecords = 4096);
+    ~BinaryTraceWriter();
+    bool isOpen() const;
+    void add(const TraceRecord &rec);
+    // Flushes the last chunk and writes the index; false on I/O error
+    bool close();
+    uint64_t records() const;
+    uint64_t bytesWritten() const;
+
+private:
+    void flushChunk();
+
+    std::ofstream out;
+    uint32_t chunkRecords;
+    std::vector<uint8_t> payload;
+    uint32_t inChunk = 0;
+    int lastPid = 0;
+    std::unordered_map<int, uint64_t> lastAddr;
+    std::vector<std::pair<uint64_t, uint64_t>> index; // offset, first record
+    uint64_t total = 0;
+    uint64_t offset = 0;
+    bool closed = false;
+};
+
+// Streams a .mtr file. A background thread reads and decodes chunks into a
+// ring buffer; next() drains it in batches.
+class BinaryTraceSource : public TraceSource
+{
+public:
+    BinaryTraceSource() = default;
+    ~BinaryTraceSource() override;
+    BinaryTraceSource(const BinaryTraceSource &) = delete;
+    BinaryTraceSource &operator=(const BinaryTraceSource &) = delete;
+
+    // Validates header, footer and index; error() explains a failure
+    bool open(const std::string &path);
+    bool next(TraceRecord &rec) override;
+    // Jumps via the index: decodes only the chunk containing `count`
+    void skip(uint64_t count) override;
+    std::string error() const override;
+    uint64_t records() const;
+
+private:
+    struct ChunkEntry
+    {
+        uint64_t offset;
+        uint64_t firstRecord;
+    };
+
+    void start(uint64_t record);
+    void stop();
+    void produce(size_t chunk, uint64_t skipInChunk);
+
+    std::string path;
+    std::vector<ChunkEntry> chunks;
+    uint64_t total = 0;
+    uint64_t indexOffset = 0;
+    uint64_t position = 0; // records handed out so far
+    std::unique_ptr<SpscRing<TraceRecord>> ring;
+    std::thread decoder;
+    bool started = false;
+    std::vector<TraceRecord> batch;
+    size_t batchPos = 0;
+    size_t batchLen = 0;
+    std::string message;
+    std::string decodeError; // written by the decoder before it closes the ring
+};
+
+// Opens a trace by content: binary if it starts with the .mtr magic, text
+// otherwise. Returns nullptr and sets error if the file cannot be used.
+std::unique_ptr<TraceSource> openTraceSource(const std::string &path, std::string &error);
@@ -5,40 +5,196 @@
 #include <cstdint>
 #include <iostream>
 #include <cmath>
+#include <string>
+#include <memory>
+#include "stats.h"
+#include "checkpoint.h"
+#include "pagepolicy.h"
+#include "swap.h"
+#include "stackdist.h"
+#include "frametable.h"
+#include <unordered_set>
 class VirtualMemory;
 
+// One memory tier, e.g. local DRAM or CXL-attached memory
+struct TierSpec
+{
+    size_t size;      // bytes
+    uint64_t latency; // cycles per access
+};
+
+// Where a newly faulted page goes while tiers still have free frames
+enum class Placement
+{
+    Fast,       // fastest tier with room
+    Interleave, // round-robin across tiers
+    Slow        // slowest tier with room; migration promotes what turns hot
+};
+
 class PhysicalMemory
 {
 public:
     PhysicalMemory(size_t ramSize, size_t pageSize, bool useLRU);
+    PhysicalMemory(size_t ramSize, size_t pageSize, ReplacementKind kind);
     void registerProcess(int pid, VirtualMemory *vm);
+    // Drops a process's registry entry and swap copies (process exit)
+    void unregisterProcess(int pid);
 
-    void access(int frameIndex);
-    int allocate(int ownerPID, uint64_t ownerVPN);
+    void access(FrameNumber frameIndex);
+    // detailed = false for functional warming: swap traffic is not timed or counted
+    FrameNumber allocate(int ownerPID, uint64_t ownerVPN, bool detailed = true);
+    // Copy-on-write: another page maps frame as well
+    void share(FrameNumber frameIndex, int pid, uint64_t vpn);
+    // Removes one mapping; the frame goes to the free list with the last one
+    void unmap(FrameNumber frameIndex, int pid, uint64_t vpn);
+    uint32_t refCount(FrameNumber frameIndex) const;
+    // True if frameIndex is a frame of this RAM mapped by page vpn of pid
+    bool mapsPage(FrameNumber frameIndex, int pid, uint64_t vpn) const;
+    // A forked child inherits the parent's swapped-out copy of a page
+    void inheritSwapped(const PageId &parent, const PageId &child);
+    // Dirty victims are written to the device and later re-faults become
+    // major faults; nullptr detaches it
+    void attachSwap(std::unique_ptr<SwapDevice> device);
+    const SwapDevice *swapDevice() const;
+    // Records every translated page reference for fault curves; nullptr stops
+    void attachCurve(std::unique_ptr<FaultCurve> curve);
+    FaultCurve *faultCurve() const;
+    // Splits RAM into tiers, fastest first (latencies must not decrease).
+    // Sizes must add up to the RAM size and no page may be resident yet.
+    bool configureTiers(const std::vector<TierSpec> &specs, std::string &error);
+    size_t tierCount() const;
+    void setPlacement(Placement placement);
+    // Every epochAccesses translations, swap up to budget hot pages into faster tiers; 0 disables
+    void setMigration(uint64_t epochAccesses, size_t budget);
+    // Page coloring: frames whose numbers agree modulo colors (a power of
+    // two) map to the same L2 sets. Free frames are then handed out by the
+    // faulting page's color, so each process's pages cycle through the
+    // colors. 0 turns it off; mapped pages keep their frames. Not combinable
+    // with tiers.
+    bool setColoring(size_t colors, std::string &error);
+    size_t colorCount() const;
+    // Hotness and per-tier accounting for one translated access
+    void countAccess(FrameNumber frameIndex);
+    // Warms the host cache for a page hit on frame: its LRU list node and
+    // heat counter
+    void prefetchFrame(FrameNumber frameIndex) const;
     void printStatus();
+    size_t framesInUse() const;
+    // Frame table entries that exist (allocated in chunks as frames are touched)
+    size_t allocatedFrameEntries() const;
+    size_t ramSize() const;
+    bool usesLRU() const;
+    ReplacementKind replacement() const;
+    // Frames mapped by more than one page
+    size_t sharedFrames() const;
+    void registerStats(stats::Registry &registry);
+    // Frame table, replacement state and fault counters (not the process registry).
+    // Only FIFO and LRU state is serialized.
+    void save(CheckpointWriter &out) const;
+    static std::unique_ptr<PhysicalMemory> restore(CheckpointReader &in);
     size_t pagesize;
     uint64_t pageFaults = 0;
     uint64_t pageHits = 0;
+    uint64_t minorFaults = 0; // counted only while a swap device is attached
+    uint64_t majorFaults = 0;
+    uint64_t clock = 0;       // paging clock in cycles, see SwapDevice
+    uint64_t forks = 0;
+    uint64_t exits = 0;
+    uint64_t framesFreed = 0;
+    uint64_t cowCopies = 0;   // shared pages duplicated on write
+    stats::Counter *statFaults = nullptr;
+    stats::Counter *statHits = nullptr;
+    stats::LabeledCounter *statFaultsByPid = nullptr;
 
 private:
+    // 16 bytes: a frame is in use while anything maps it
     struct FrameInfo
     {
-        bool isUsed = false;
         uint64_t ownerVPN = 0;
-        int ownerPID = -1;
+        int32_t ownerPID = -1;
+        uint32_t refCount = 0; // owner plus sharers
+        bool used() const { return refCount != 0; }
     };
 
     size_t numFrames;
     bool isLRU;
+    ReplacementKind kind;
+    std::unique_ptr<PagePolicy> policy; // ARC, 2Q, LFU
 
-    std::vector<FrameInfo> frames;
+    FrameTable<FrameInfo> frames; // chunks appear as frames are first used
     std::unordered_map<int, VirtualMemory *> processRegistry;
 
-    size_t nextFreeFrameIndex = 0;
-    bool isFull = false;
-    int fifoPointer = 0;
-    std::list<int> lruList;
-    std::unordered_map<int, std::list<int>::iterator> lruMap;
+    size_t nextFreeFrameIndex = 0; // frames at or above have never been used
+    size_t usedFrames = 0;
+    std::vector<FrameNumber> freeFrames; // freed below nextFreeFrameIndex (untiered)
+    // mappings besides the owner for copy-on-write frames
+    std::unordered_map<FrameNumber, std::vector<PageId>> sharers;
+    FrameNumber fifoPointer = 0;
+    std::list<FrameNumber> lruList;
+    std::unordered_map<FrameNumber, std::list<FrameNumber>::iterator> lruMap;
+    struct Tier
+    {
+        TierSpec spec;
+        size_t first = 0, count = 0;
+        size_t next = 0;             // frames below next have been handed out
+        std::vector<FrameNumber> freeFrames; // handed out, then vacated by migration
+        uint64_t accesses = 0;
+    };
+    std::vector<Tier> tiers; // empty: one flat pool
+    FrameTable<uint32_t> heat; // accesses per frame, halved every epoch
+    Placement placement = Placement::Fast;
+    size_t interleaveNext = 0;
+    uint64_t epochLength = 0;
+    size_t epochBudget = 0;
+    uint64_t epochTicks = 0;
+    uint64_t promotions = 0;
+    uint64_t demotions = 0;
+    size_t colors = 0;                               // 0: coloring off
+    std::vector<std::vector<FrameNumber>> colorFree; // freed frames by color, lowest last
+    std::vector<FrameNumber> colorNext;              // next never-used frame of each color
+    std::unordered_map<int, size_t> colorOffsets;    // pid -> first color
+    uint64_t coloredPages = 0;
+    uint64_t offColorPages = 0; // wanted color had no free frame
+
+    FrameNumber takeFreeFrame(const PageId &page);
+    FrameNumber takeColoredFrame(const PageId &page);
+    // Appends every free frame below the returned watermark; frames at or
+    // above it have never been used
+    size_t freeFrameList(std::vector<FrameNumber> &free) const;
+    void releaseFrame(FrameNumber frame);
+    void evictFrame(FrameNumber frame, bool detailed);
+    void moveSharers(FrameNumber from, FrameNumber to);
+    void remapMappings(FrameNumber frame);
+    // fn(pid, vpn) for the owner and every sharer of frame
+    template <typename Fn>
+    void forEachMapping(FrameNumber frame, Fn fn) const
+    {
+        FrameInfo info = frames[frame];
+        fn(info.ownerPID, info.ownerVPN);
+        auto it = sharers.find(frame);
+        if (it != sharers.end())
+        {
+            for (const PageId &page : it->second)
+                fn(page.pid, page.vpn);
+        }
+    }
+
+    bool tierHasRoom(size_t t) const;
+    size_t tierOf(FrameNumber frame) const;
+    FrameNumber takeTierFrame(size_t t);
+    FrameNumber placeNewPage();
+    void movePage(FrameNumber from, FrameNumber to);
+    void exchangePages(FrameNumber a, FrameNumber b);
+    void migrate();
+    void printTiers() const;
+
+    std::unique_ptr<SwapDevice> swap;
+    std::unique_ptr<FaultCurve> curve;
+    std::unordered_set<PageId, PageIdHash> swapped; // pages with a copy on the device
+    stats::Counter *statEvictions = nullptr;
+    stats::LabeledCounter *statEvictionsByPid = nullptr;
+    stats::Counter *statMajorFaults = nullptr;
+    stats::Counter *statSwapOuts = nullptr;
 };
 
 class VirtualMemory
@@ -48,15 +204,37 @@ public:
 
     VirtualMemory(PhysicalMemory *pm);
 
-    uint64_t translate(uint64_t virtualAddr);
+    // write sets the page's dirty bit
+    uint64_t translate(uint64_t virtualAddr, bool write = false);
+    // translate() on each of count addresses in order. The page-table
+    // lookups of a block are done up front, and frames they hit prefetched,
+    // before any of it is resolved.
+    void translateBatch(const uint64_t *virtualAddrs, const bool *writes, size_t count, uint64_t *physicalAddrs);
+    // Functional warming: updates page table and frame state without counting hits/faults
+    uint64_t warm(uint64_t virtualAddr, bool write = false);
+
+    // Returns whether the page was dirty
+    bool invalidatePage(uint64_t vpn);
+    // The page's frame moved (tier migration)
+    void remapPage(uint64_t vpn, FrameNumber frameNumber);
+    // New process childPid sharing every resident page copy-on-write
+    std::unique_ptr<VirtualMemory> fork(int childPid);
+    // Process exit: unmaps every page and leaves the registry
+    void release();
+    size_t residentPages() const;
+    int getPid() const;
 
-    void invalidatePage(uint64_t vpn);
+    void save(CheckpointWriter &out) const;
+    // Rebuilds a process's page table and registers it with pm
+    static std::unique_ptr<VirtualMemory> restore(CheckpointReader &in, PhysicalMemory *pm);
 
 private:
     struct PageTableEntry
     {
         bool valid = false;
-        int frameNumber = -1;
+        bool dirty = false;
+        bool cow = false; // shared with a fork; the next write copies
+        FrameNumber frameNumber = -1;
     };
 
     PhysicalMemory *physMem;
@@ -65,4 +243,6 @@ private:
     int offsetBits;
 
     std::unordered_map<uint64_t, PageTableEntry> pageTable;
+    uint64_t resolve(uint64_t virtualAddr, bool write, bool detailed);
+    uint64_t resolve(PageTableEntry &pte, uint64_t virtualAddr, bool write, bool detailed);
 };
\ No newline at end of file
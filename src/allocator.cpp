@@ -44,9 +44,13 @@ void Memory::addblock(std::list<block>::iterator it, std::size_t size){
         it->len= size;
     }
     usedmemory+=size;
+    STAT_INC(stat_successes);
+    STAT_RECORD(stat_block_size, size);
+    update_gauges();
 }
 int Memory::allocate_firstfit(std::size_t size){
     attempts++;
+    STAT_INC(stat_attempts);
     for(auto it = mem_list.begin();it!=mem_list.end();++it){
         if(it->is_free&&it->len>=size){
             addblock(it,size);
@@ -57,6 +61,7 @@ int Memory::allocate_firstfit(std::size_t size){
 }
 int Memory::allocate_bestfit(std::size_t size) {
     attempts++;
+    STAT_INC(stat_attempts);
     auto it_ = index.lower_bound(size); 
     
     if (it_ != index.end()) {
@@ -68,13 +73,15 @@ int Memory::allocate_bestfit(std::size_t size) {
 }
 int Memory :: allocate_worstfit(std::size_t size){
     attempts++;
+    STAT_INC(stat_attempts);
     if (index.empty()){
         return -1;
     }
-    auto it_ = index.rbegin();
-    if((*it_)->len>=size){
-        addblock(*it_,size);
-        return (*it_)->id;
+    // take the block before addblock() drops it from the index
+    std::list<block>::iterator target = *index.rbegin();
+    if(target->len>=size){
+        addblock(target,size);
+        return target->id;
     }
     return -1;
 }
@@ -102,6 +109,80 @@ void Memory::free(int id){
         mem_list.erase(next);
     }
     add_index(it);
+    STAT_INC(stat_frees);
+    update_gauges();
+}
+bool Memory::block_at(int id, std::size_t &addr, std::size_t &len) const{
+    auto map_it = id_map.find(id);
+    if(map_it == id_map.end()) return false;
+    addr = map_it->second->addr;
+    len = map_it->second->len;
+    return true;
+}
+void Memory::registerStats(stats::Registry &registry){
+    stat_attempts = registry.counter("alloc.attempts");
+    stat_successes = registry.counter("alloc.successes");
+    stat_frees = registry.counter("alloc.frees");
+    stat_block_size = registry.histogram("alloc.block_size");
+    stat_ext_frag = registry.gauge("alloc.ext_frag");
+    stat_used = registry.gauge("alloc.used_bytes");
+    stat_free_blocks = registry.gauge("alloc.free_blocks");
+    update_gauges();
+}
+void Memory::update_gauges(){
+    STAT_SET(stat_ext_frag, ext_frag());
+    STAT_SET(stat_used, usedmemory);
+    STAT_SET(stat_free_blocks, index.size());
+}
+void Memory::save(CheckpointWriter &out) const{
+    out.put<uint64_t>(totalsize);
+    out.put<int32_t>(next_id);
+    out.put<int64_t>(attempts);
+    out.put<int64_t>(hits);
+    out.put<uint64_t>(usedmemory);
+    out.put<uint64_t>(mem_list.size());
+    for(const auto &b : mem_list){
+        out.put<uint64_t>(b.addr);
+        out.put<uint64_t>(b.len);
+        out.put<uint8_t>(b.is_free);
+        out.put<int32_t>(b.id);
+    }
+}
+std::unique_ptr<Memory> Memory::restore(CheckpointReader &in){
+    auto m = std::make_unique<Memory>(in.get<uint64_t>());
+    m->next_id = in.get<int32_t>();
+    m->attempts = in.get<int64_t>();
+    m->hits = in.get<int64_t>();
+    m->usedmemory = in.get<uint64_t>();
+    uint64_t count = in.getCount(2 * sizeof(uint64_t) + 1 + sizeof(int32_t));
+    if(!in.ok() || count == 0) {
+        in.fail("corrupt block list");
+        return nullptr;
+    }
+    // rebuild the block list, then the id lookup and free-block index from it
+    m->mem_list.clear();
+    m->index.clear();
+    std::size_t expected = 0;
+    for(uint64_t i = 0; i < count; i++){
+        block b;
+        b.addr = in.get<uint64_t>();
+        b.len = in.get<uint64_t>();
+        b.is_free = in.get<uint8_t>();
+        b.id = in.get<int32_t>();
+        if(b.addr != expected){
+            in.fail("block list is not contiguous");
+            return nullptr;
+        }
+        expected += b.len;
+        auto it = m->mem_list.insert(m->mem_list.end(), b);
+        if(b.is_free) m->add_index(it);
+        else m->id_map[b.id] = it;
+    }
+    if(!in.ok() || expected != m->totalsize){
+        in.fail("block list does not cover memory");
+        return nullptr;
+    }
+    return m;
 }
 void Memory::dump() const {
     std::cout << "--- Memory Dump ---" << std::endl;
@@ -0,0 +1,355 @@
+#include "bitmap.h"
+#include "allocator.h"
+#include "generators.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+    const uint64_t ALL = ~0ULL;
+
+    // bits [lo, hi) of a word, 0 <= lo < hi <= 64
+    uint64_t bit_range(std::size_t lo, std::size_t hi) {
+        uint64_t upper = hi == 64 ? ALL : ((1ULL << hi) - 1);
+        return upper & (ALL << lo);
+    }
+}
+
+BitmapMemory::BitmapMemory(std::size_t size, std::size_t unit_)
+:unit(unit_ ? unit_ : 1),
+units(size / unit)
+{
+    bits.assign((units + 63) / 64, 0);
+    full.assign((bits.size() + 63) / 64, 0);
+    groups.resize(full.size());
+    widen_groups(0, units);
+    if (units % 64)
+        bits.back() = ALL << (units % 64);
+    // summary bits past the last word read as full, so scans stop by themselves
+    if (bits.size() % 64)
+        full.back() = ALL << (bits.size() % 64);
+    for (std::size_t w = 0; w < bits.size(); w++) {
+        if (bits[w] == ALL)
+            full[w / 64] |= 1ULL << (w % 64);
+    }
+}
+
+std::size_t BitmapMemory::next_free(std::size_t pos) const {
+    if (pos >= units)
+        return NONE;
+    std::size_t w = pos / 64;
+    uint64_t open = ~bits[w] & (ALL << (pos % 64));
+    if (open)
+        return w * 64 + __builtin_ctzll(open);
+    // skip allocated words 64 at a time through the summary
+    for (std::size_t nw = w + 1; nw < bits.size();) {
+        std::size_t sw = nw / 64;
+        uint64_t partial = ~full[sw] & (ALL << (nw % 64));
+        if (partial) {
+            nw = sw * 64 + __builtin_ctzll(partial);
+            return nw * 64 + __builtin_ctzll(~bits[nw]);
+        }
+        nw = (sw + 1) * 64;
+    }
+    return NONE;
+}
+
+std::size_t BitmapMemory::free_run_end(std::size_t pos, std::size_t limit) const {
+    std::size_t w = pos / 64;
+    uint64_t used = bits[w] & (ALL << (pos % 64));
+    if (used)
+        return std::min(w * 64 + __builtin_ctzll(used), limit);
+    for (w++; w * 64 < limit;) {
+#ifdef __SSE2__
+        // two free words at once
+        if (w + 1 < bits.size()) {
+            __m128i pair = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&bits[w]));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(pair, _mm_setzero_si128())) == 0xFFFF) {
+                w += 2;
+                continue;
+            }
+        }
+#endif
+        if (bits[w])
+            return std::min(w * 64 + __builtin_ctzll(bits[w]), limit);
+        w++;
+    }
+    return limit;
+}
+
+std::size_t BitmapMemory::free_run_start(std::size_t pos) const {
+    std::size_t w = pos / 64;
+    uint64_t used = bits[w] & ~(ALL << (pos % 64));
+    while (!used) {
+        if (w == 0)
+            return 0;
+        used = bits[--w];
+    }
+    return w * 64 + 64 - __builtin_clzll(used);
+}
+
+void BitmapMemory::widen_groups(std::size_t first, std::size_t end) {
+    for (std::size_t g = first / GROUP_UNITS; g * GROUP_UNITS < end; g++) {
+        std::size_t begin = g * GROUP_UNITS, stop = std::min(units, begin + GROUP_UNITS);
+        std::size_t lo = std::max(first, begin), hi = std::min(end, stop);
+        group_info &info = groups[g];
+        info.largest = std::max(info.largest, hi - lo);
+        if (lo == begin)
+            info.prefix = std::max(info.prefix, hi - lo);
+        if (hi == stop)
+            info.suffix = std::max(info.suffix, hi - lo);
+    }
+}
+
+std::size_t BitmapMemory::find_run(std::size_t count) {
+    std::size_t pos = next_free(hint);
+    if (pos == NONE)
+        return NONE;
+    hint = pos;
+    for (std::size_t g = pos / GROUP_UNITS; g < groups.size(); g++) {
+        // a run starting in g lies inside it or continues from its free suffix
+        std::size_t reach = groups[g].suffix;
+        for (std::size_t n = g + 1; reach && reach < count && n < groups.size(); n++) {
+            reach += groups[n].prefix;
+            if (groups[n].prefix < GROUP_UNITS)
+                break;
+        }
+        if (groups[g].largest < count && reach < count)
+            continue;
+        std::size_t end = std::min(units, (g + 1) * GROUP_UNITS);
+        for (pos = next_free(std::max(pos, g * GROUP_UNITS)); pos != NONE && pos < end && pos + count <= units;) {
+            std::size_t run_end = free_run_end(pos, pos + count);
+            if (run_end == pos + count)
+                return pos;
+            pos = next_free(run_end);
+        }
+        // nothing here fits count units, so every run in the group is shorter
+        group_info &info = groups[g];
+        info.largest = std::min(info.largest, count - 1);
+        info.prefix = std::min(info.prefix, count - 1);
+        info.suffix = std::min(info.suffix, count - 1);
+    }
+    return NONE;
+}
+
+void BitmapMemory::set_range(std::size_t first, std::size_t count) {
+    for (std::size_t pos = first, end = first + count; pos < end;) {
+        std::size_t w = pos / 64;
+        std::size_t hi = std::min<std::size_t>(64, end - w * 64);
+        bits[w] |= bit_range(pos % 64, hi);
+        if (bits[w] == ALL)
+            full[w / 64] |= 1ULL << (w % 64);
+        pos = w * 64 + hi;
+    }
+}
+
+void BitmapMemory::clear_range(std::size_t first, std::size_t count) {
+    for (std::size_t pos = first, end = first + count; pos < end;) {
+        std::size_t w = pos / 64;
+        std::size_t hi = std::min<std::size_t>(64, end - w * 64);
+        bits[w] &= ~bit_range(pos % 64, hi);
+        full[w / 64] &= ~(1ULL << (w % 64));
+        pos = w * 64 + hi;
+    }
+}
+
+int BitmapMemory::allocate(std::size_t size) {
+    attempts++;
+    STAT_INC(stat_attempts);
+    std::size_t count = std::max<std::size_t>(1, (size + unit - 1) / unit);
+    std::size_t first = count <= units ? find_run(count) : NONE;
+    if (first == NONE)
+        return -1;
+    set_range(first, count);
+    int id = next_id++;
+    live[id] = span{first, count, size};
+    hits++;
+    used_units += count;
+    requested_bytes += size;
+    STAT_INC(stat_successes);
+    STAT_RECORD(stat_block_size, size);
+    STAT_SET(stat_used, used_memory());
+    return id;
+}
+
+void BitmapMemory::free(int id) {
+    auto it = live.find(id);
+    if (it == live.end())
+        return;
+    std::size_t first = it->second.first, end = first + it->second.count;
+    clear_range(first, it->second.count);
+    widen_groups(free_run_start(first), end < units ? free_run_end(end, units) : units);
+    hint = std::min(hint, first);
+    used_units -= it->second.count;
+    requested_bytes -= it->second.requested;
+    live.erase(it);
+    STAT_INC(stat_frees);
+    STAT_SET(stat_used, used_memory());
+}
+
+bool BitmapMemory::block_at(int id, std::size_t &addr, std::size_t &len) const {
+    auto it = live.find(id);
+    if (it == live.end())
+        return false;
+    addr = it->second.first * unit;
+    len = it->second.count * unit;
+    return true;
+}
+
+void BitmapMemory::dump() const {
+    std::vector<std::pair<std::size_t, int>> blocks;
+    for (const auto &b : live)
+        blocks.push_back({b.second.first, b.first});
+    std::sort(blocks.begin(), blocks.end());
+    std::cout << "--- Memory Dump (bitmap, " << unit << "-byte units) ---" << std::endl;
+    std::size_t pos = 0;
+    auto print_free = [&](std::size_t end) {
+        if (end > pos)
+            std::cout << "[" << pos * unit << " - " << end * unit - 1 << "] Size: " << (end - pos) * unit << " (FREE)" << std::endl;
+    };
+    for (const auto &b : blocks) {
+        const span &s = live.at(b.second);
+        print_free(s.first);
+        std::cout << "[" << s.first * unit << " - " << (s.first + s.count) * unit - 1
+                  << "] Size: " << s.count * unit << " (ID: " << b.second << ")" << std::endl;
+        pos = s.first + s.count;
+    }
+    print_free(units);
+}
+
+double BitmapMemory::ext_frag() const {
+    std::size_t free_units = units - used_units;
+    if (free_units == 0)
+        return 0.0;
+    std::size_t largest = 0;
+    for (std::size_t pos = next_free(0); pos != NONE;) {
+        std::size_t end = free_run_end(pos, units);
+        largest = std::max(largest, end - pos);
+        pos = next_free(end);
+    }
+    return 1.0 - (static_cast<double>(largest) / free_units);
+}
+
+double BitmapMemory::int_frag() const {
+    if (used_units == 0)
+        return 0.0;
+    return 1.0 - static_cast<double>(requested_bytes) / used_memory();
+}
+
+double BitmapMemory::alloc_success_rate() const {
+    if (attempts == 0)
+        return 0.0;
+    return (static_cast<double>(hits) / attempts) * 100.0;
+}
+
+std::size_t BitmapMemory::total_memory() const {
+    return units * unit;
+}
+
+std::size_t BitmapMemory::used_memory() const {
+    return used_units * unit;
+}
+
+std::size_t BitmapMemory::unit_size() const {
+    return unit;
+}
+
+void BitmapMemory::registerStats(stats::Registry &registry) {
+    stat_attempts = registry.counter("alloc.attempts");
+    stat_successes = registry.counter("alloc.successes");
+    stat_frees = registry.counter("alloc.frees");
+    stat_block_size = registry.histogram("alloc.block_size");
+    stat_used = registry.gauge("alloc.used_bytes");
+    STAT_SET(stat_used, used_memory());
+}
+
+namespace {
+    // slot < 0: free slot ~slot; otherwise allocate `size` into slot
+    struct bench_op {
+        long long slot;
+        std::size_t size;
+    };
+
+    template <typename Alloc, typename Free>
+    double run_ops(const std::vector<bench_op> &ops, std::vector<int> &ids, Alloc alloc, Free release) {
+        auto start = std::chrono::steady_clock::now();
+        for (const bench_op &op : ops) {
+            if (op.slot >= 0) {
+                ids[op.slot] = alloc(op.size);
+            } else if (ids[~op.slot] != -1) {
+                release(ids[~op.slot]);
+                ids[~op.slot] = -1;
+            }
+        }
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+void bench_allocators(std::size_t size, std::size_t unit, uint64_t ops, std::size_t max_size, uint64_t seed) {
+    size = size / unit * unit;
+    // mallocs until the heap is about 3/4 full, then random frees and mallocs
+    // alternate around that level, fragmenting it as they go
+    FastRandom rng(seed);
+    std::vector<bench_op> plan;
+    std::vector<std::pair<long long, std::size_t>> occupied; // slot, bytes
+    std::size_t planned = 0;
+    long long slots = 0;
+    plan.reserve(ops);
+    for (uint64_t i = 0; i < ops; i++) {
+        std::size_t bytes = (1 + rng.below(max_size) + unit - 1) / unit * unit;
+        if (occupied.empty() || (planned + bytes <= size / 4 * 3 && rng.below(4) != 0)) {
+            plan.push_back({slots, bytes});
+            occupied.push_back({slots++, bytes});
+            planned += bytes;
+        } else {
+            std::size_t k = rng.below(occupied.size());
+            plan.push_back({~occupied[k].first, 0});
+            planned -= occupied[k].second;
+            occupied[k] = occupied.back();
+            occupied.pop_back();
+        }
+    }
+
+    Memory first(size), best(size);
+    BitmapMemory bitmap(size, unit);
+    std::vector<int> first_ids(slots, -1), best_ids(slots, -1), bitmap_ids(slots, -1);
+    double first_time = run_ops(plan, first_ids,
+        [&](std::size_t n) { return first.allocate_firstfit(n); }, [&](int id) { first.free(id); });
+    double best_time = run_ops(plan, best_ids,
+        [&](std::size_t n) { return best.allocate_bestfit(n); }, [&](int id) { best.free(id); });
+    double bitmap_time = run_ops(plan, bitmap_ids,
+        [&](std::size_t n) { return bitmap.allocate(n); }, [&](int id) { bitmap.free(id); });
+
+    // compare the live blocks left at the end
+    bool match = true;
+    for (long long s = 0; s < slots && match; s++) {
+        std::size_t a1 = 0, l1 = 0, a2 = 0, l2 = 0;
+        bool in_first = first_ids[s] != -1 && first.block_at(first_ids[s], a1, l1);
+        bool in_bitmap = bitmap_ids[s] != -1 && bitmap.block_at(bitmap_ids[s], a2, l2);
+        match = in_first == in_bitmap && a1 == a2 && l1 == l2;
+    }
+
+    std::ios format(nullptr);
+    format.copyfmt(std::cout);
+    std::cout << "\n========== Allocator Benchmark ==========\n";
+    std::cout << "Heap: " << size << " bytes | Unit: " << unit << " | Ops: " << ops
+              << " | Sizes: 1-" << max_size << " | Seed: " << seed << "\n";
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << std::setw(10) << "Allocator" << std::setw(12) << "Mops/s" << std::setw(10) << "ns/op"
+              << std::setw(11) << "Success" << std::setw(11) << "Ext Frag" << "\n";
+    auto row = [&](const char *name, double seconds, double success, double frag) {
+        std::cout << std::setw(10) << name << std::setw(12) << (seconds > 0 ? ops / seconds / 1e6 : 0.0)
+                  << std::setw(10) << seconds * 1e9 / std::max<uint64_t>(1, ops)
+                  << std::setw(10) << success << "%" << std::setw(10) << frag * 100 << "%\n";
+    };
+    row("first", first_time, first.alloc_success_rate(), first.ext_frag());
+    row("best", best_time, best.alloc_success_rate(), best.ext_frag());
+    row("bitmap", bitmap_time, bitmap.alloc_success_rate(), bitmap.ext_frag());
+    std::cout << "Bitmap placements match first fit: " << (match ? "yes" : "NO") << "\n";
+    std::cout << "=========================================\n";
+    std::cout.copyfmt(format);
+}
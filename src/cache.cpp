@@ -2,6 +2,15 @@
 #include <cmath>
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
+
+namespace
+{
+    // Accesses decoded per pass of a batch, and the distance in accesses
+    // between prefetch stages
+    const size_t BATCH_CHUNK = 256;
+    const size_t PREFETCH_AHEAD = 8;
+}
 
 Cache::Cache(size_t cSize, size_t bSize, int assoc, bool useLRU_)
     : blockSize(bSize), associativity(assoc), isLRU(useLRU_)
@@ -10,61 +19,31 @@ Cache::Cache(size_t cSize, size_t bSize, int assoc, bool useLRU_)
     // calculate bits for decoding (assuming powers of 2)
     offsetBits = std::log2(blockSize);
     indexBits = std::log2(numSets);
-    // initialize memory
+    // lines are allocated per set on first access
     sets.resize(numSets);
-    for (auto &set : sets)
-    {
-        set.lines.resize(associativity);
-    }
-    if (associativity > 1)
-    {
-        if (isLRU)
-        {
-            initLRU();
-        }
-        else
-        {
-            initFIFO();
-        }
-    }
 }
 
 Cache::Cache(size_t cSize, size_t bSize, int assoc)
-    : blockSize(bSize), associativity(assoc), isLRU(false)
-{
-    numSets = cSize / (blockSize * associativity);
-    offsetBits = std::log2(blockSize);
-    indexBits = std::log2(numSets);
-    // Initialize Memory
-    sets.resize(numSets);
-    for (auto &set : sets)
-    {
-        set.lines.resize(associativity);
-    }
-    if (associativity > 1)
-    {
-        initFIFO();
-    }
-}
-
-void Cache::initFIFO()
+    : Cache(cSize, bSize, assoc, false)
 {
-    fifoNextVictim.resize(numSets, 0);
 }
 
-void Cache::initLRU()
+Cache::CacheSet &Cache::materialize(uint64_t setIndex)
 {
-    lruLists.resize(numSets);
-    lruMaps.resize(numSets);
-    // assuming in index fill in way 0,1,2... when cache is empty
-    for (size_t i = 0; i < numSets; i++)
+    std::unique_ptr<CacheSet> &set = sets[setIndex];
+    if (set)
+        return *set;
+    set = std::make_unique<CacheSet>();
+    set->lines.resize(associativity);
+    if (associativity > 1 && isLRU)
     {
+        // an empty set fills way 0, 1, 2, ...
+        set->lruPos.resize(associativity);
         for (int lineIdx = 0; lineIdx < associativity; lineIdx++)
-        {
-            lruLists[i].push_back(lineIdx);
-            lruMaps[i][lineIdx] = std::prev(lruLists[i].end());
-        }
+            set->lruPos[lineIdx] = set->lruList.insert(set->lruList.end(), lineIdx);
     }
+    touchedSets++;
+    return *set;
 }
 
 Cache::DecodedAddress Cache::decodeAddress(uint64_t physicalAddress) const
@@ -79,41 +58,66 @@ Cache::DecodedAddress Cache::decodeAddress(uint64_t physicalAddress) const
 bool Cache::access(uint64_t physicalAddress, bool write)
 {
     DecodedAddress addr = decodeAddress(physicalAddress);
-    CacheSet &set = sets[addr.setIndex];
+    // an untouched set is a certain miss into way 0
+    bool untouched = !sets[addr.setIndex];
+    CacheSet &set = materialize(addr.setIndex);
+    lastPrefetchHit = false;
+    lastVictimValid = false;
     if (associativity == 1)
     {
         CacheLine &line = set.lines[0];
-        if (write)
-        {
-            line.modified = true;
-        }
         if (line.valid && line.tag == addr.tag)
         {
             hits++;
+            STAT_INC(statHits);
+            if (write)
+            {
+                line.modified = true;
+            }
+            onDemandHit(line);
             return true;
         }
+        bool victimDirty = line.modified;
         misses++;
+        STAT_INC(statMisses);
+        STAT_INC_AT(statSetMisses, addr.setIndex);
+        onDemandMiss(physicalAddress);
+        onReplace(line);
+        if (line.valid)
+        {
+            STAT_INC(statEvictions);
+            STAT_INC_AT(statSetConflictMisses, addr.setIndex);
+            if (victimDirty)
+                STAT_INC(statDirtyEvictions);
+        }
         line.valid = true;
         line.tag = addr.tag;
         line.phyAddr = physicalAddress;
+        line.modified = write;
+        line.prefetched = false;
         return false;
     }
-    for (int i = 0; i < associativity; i++)
+    for (int i = 0; i < associativity && !untouched; i++)
     {
         if (set.lines[i].valid && set.lines[i].tag == addr.tag)
         {
             hits++;
+            STAT_INC(statHits);
             if (write)
             {
                 set.lines[i].modified = true;
             }
-            updatePolicyOnHit(addr.setIndex, i);
+            onDemandHit(set.lines[i]);
+            updatePolicyOnHit(set, i);
             return true;
         }
     }
     misses++;
-    int targetIndex = -1;
-    for (int i = 0; i < associativity; i++)
+    STAT_INC(statMisses);
+    STAT_INC_AT(statSetMisses, addr.setIndex);
+    onDemandMiss(physicalAddress);
+    int targetIndex = untouched ? 0 : -1;
+    for (int i = 0; i < associativity && targetIndex == -1; i++)
     {
         if (!set.lines[i].valid)
         {
@@ -123,51 +127,306 @@ bool Cache::access(uint64_t physicalAddress, bool write)
     }
     if (targetIndex == -1)
     {
-        targetIndex = getVictimIndex(addr.setIndex);
+        targetIndex = getVictimIndex(set);
+        STAT_INC(statEvictions);
+        STAT_INC_AT(statSetConflictMisses, addr.setIndex);
+        if (set.lines[targetIndex].modified)
+            STAT_INC(statDirtyEvictions);
+        onReplace(set.lines[targetIndex]);
     }
     set.lines[targetIndex].valid = true;
     set.lines[targetIndex].tag = addr.tag;
     set.lines[targetIndex].phyAddr = physicalAddress;
-    if (write)
-        set.lines[targetIndex].modified = true;
-    updatePolicyOnReplace(addr.setIndex, targetIndex);
+    set.lines[targetIndex].prefetched = false;
+    set.lines[targetIndex].modified = write;
+    updatePolicyOnReplace(set, targetIndex);
+    return false;
+}
+void Cache::accessBatch(const uint64_t *physicalAddresses, const bool *writes, size_t count, bool *hitFlags)
+{
+    uint64_t setIndex[BATCH_CHUNK];
+    for (size_t base = 0; base < count; base += BATCH_CHUNK)
+    {
+        size_t n = std::min(BATCH_CHUNK, count - base);
+        const uint64_t *addrs = physicalAddresses + base;
+        for (size_t i = 0; i < n; i++)
+            setIndex[i] = decodeAddress(addrs[i]).setIndex;
+        // Three dependent loads per access (set slot, set, lines), each
+        // prefetched one stage before the next one reads it
+        for (size_t i = 0; i < n; i++)
+        {
+            if (i + 3 * PREFETCH_AHEAD < n)
+                __builtin_prefetch(&sets[setIndex[i + 3 * PREFETCH_AHEAD]]);
+            if (i + 2 * PREFETCH_AHEAD < n)
+            {
+                if (CacheSet *set = sets[setIndex[i + 2 * PREFETCH_AHEAD]].get())
+                    __builtin_prefetch(set);
+            }
+            if (i + PREFETCH_AHEAD < n)
+            {
+                if (CacheSet *set = sets[setIndex[i + PREFETCH_AHEAD]].get())
+                {
+                    __builtin_prefetch(set->lines.data());
+                    __builtin_prefetch(&set->lines.back());
+                }
+            }
+            bool hit = access(addrs[i], writes[i]);
+            if (hitFlags)
+                hitFlags[base + i] = hit;
+        }
+    }
+}
+bool Cache::warm(uint64_t physicalAddress, bool write)
+{
+    DecodedAddress addr = decodeAddress(physicalAddress);
+    CacheSet &set = materialize(addr.setIndex);
+    int targetIndex = -1;
+    for (int i = 0; i < associativity; i++)
+    {
+        CacheLine &line = set.lines[i];
+        if (line.valid && line.tag == addr.tag)
+        {
+            if (write)
+                line.modified = true;
+            line.prefetched = false;
+            if (associativity > 1)
+                updatePolicyOnHit(set, i);
+            return true;
+        }
+        if (!line.valid && targetIndex == -1)
+            targetIndex = i;
+    }
+    if (targetIndex == -1)
+        targetIndex = (associativity == 1) ? 0 : getVictimIndex(set);
+    CacheLine &line = set.lines[targetIndex];
+    line.valid = true;
+    line.tag = addr.tag;
+    line.phyAddr = physicalAddress;
+    line.prefetched = false;
+    line.modified = write;
+    if (associativity > 1)
+        updatePolicyOnReplace(set, targetIndex);
     return false;
 }
-void Cache::updatePolicyOnHit(int setIndex, int lineIndex)
+
+void Cache::onDemandHit(CacheLine &line)
+{
+    if (missShadow)
+        classify(line.phyAddr, true);
+    if (line.prefetched)
+    {
+        line.prefetched = false;
+        lastPrefetchHit = true;
+        prefetch.useful++;
+        STAT_INC(statPrefetchUseful);
+    }
+}
+
+void Cache::onDemandMiss(uint64_t physicalAddress)
+{
+    if (missShadow)
+        classify(physicalAddress, false);
+    if (prefetchVictims.empty())
+        return;
+    if (prefetchVictims.erase(physicalAddress >> offsetBits))
+    {
+        prefetch.pollution++;
+        STAT_INC(statPrefetchPollution);
+    }
+}
+
+void Cache::classify(uint64_t physicalAddress, bool hit)
+{
+    uint64_t block = physicalAddress >> offsetBits;
+    MissShadow &shadow = *missShadow;
+    auto it = shadow.where.find(block);
+    bool shadowHit = it != shadow.where.end();
+    if (shadowHit)
+    {
+        shadow.lru.splice(shadow.lru.begin(), shadow.lru, it->second);
+    }
+    else
+    {
+        shadow.lru.push_front(block);
+        shadow.where[block] = shadow.lru.begin();
+        if (shadow.lru.size() > numSets * associativity)
+        {
+            shadow.where.erase(shadow.lru.back());
+            shadow.lru.pop_back();
+        }
+    }
+    if (hit)
+        return;
+    if (shadow.seen.insert(block).second)
+        shadow.types.compulsory++;
+    else if (shadowHit)
+        shadow.types.conflict++;
+    else
+        shadow.types.capacity++;
+}
+
+void Cache::classifyMisses(bool on)
+{
+    if (!on)
+        missShadow.reset();
+    else if (!missShadow)
+        missShadow = std::make_unique<MissShadow>();
+}
+
+const Cache::MissTypes *Cache::getMissTypes() const
+{
+    return missShadow ? &missShadow->types : nullptr;
+}
+
+void Cache::onReplace(const CacheLine &victim)
+{
+    if (!victim.valid)
+        return;
+    lastVictimValid = true;
+    lastVictimBlock = victim.phyAddr & ~(uint64_t)(blockSize - 1);
+    if (victim.prefetched)
+        prefetch.unused++;
+}
+
+bool Cache::contains(uint64_t physicalAddress) const
+{
+    DecodedAddress addr = decodeAddress(physicalAddress);
+    if (!sets[addr.setIndex])
+        return false;
+    for (const auto &line : sets[addr.setIndex]->lines)
+    {
+        if (line.valid && line.tag == addr.tag)
+            return true;
+    }
+    return false;
+}
+
+bool Cache::invalidate(uint64_t physicalAddress)
+{
+    DecodedAddress addr = decodeAddress(physicalAddress);
+    if (!sets[addr.setIndex])
+        return false;
+    for (auto &line : sets[addr.setIndex]->lines)
+    {
+        if (line.valid && line.tag == addr.tag)
+        {
+            line.valid = false;
+            line.modified = false;
+            line.prefetched = false;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Cache::prefetchFill(uint64_t physicalAddress)
+{
+    DecodedAddress addr = decodeAddress(physicalAddress);
+    CacheSet &set = materialize(addr.setIndex);
+    int targetIndex = -1;
+    for (int i = 0; i < associativity; i++)
+    {
+        if (set.lines[i].valid && set.lines[i].tag == addr.tag)
+            return false;
+        if (!set.lines[i].valid && targetIndex == -1)
+            targetIndex = i;
+    }
+    if (targetIndex == -1)
+    {
+        targetIndex = (associativity == 1) ? 0 : getVictimIndex(set);
+        CacheLine &victim = set.lines[targetIndex];
+        STAT_INC(statEvictions);
+        if (victim.modified)
+            STAT_INC(statDirtyEvictions);
+        onReplace(victim);
+        lastVictimValid = false;
+        if (!victim.prefetched)
+        {
+            // bound the tracker to the cache's capacity in blocks
+            if (prefetchVictims.size() >= numSets * associativity)
+                prefetchVictims.clear();
+            prefetchVictims.insert(victim.phyAddr >> offsetBits);
+        }
+    }
+    CacheLine &line = set.lines[targetIndex];
+    line.valid = true;
+    line.tag = addr.tag;
+    line.phyAddr = physicalAddress;
+    line.modified = false;
+    line.prefetched = true;
+    if (associativity > 1)
+        updatePolicyOnReplace(set, targetIndex);
+    prefetch.fills++;
+    STAT_INC(statPrefetchFills);
+    return true;
+}
+
+void Cache::updatePolicyOnHit(CacheSet &set, int lineIndex)
 {
     if (isLRU)
     {
-        auto &list = lruLists[setIndex];
-        auto &map = lruMaps[setIndex];
         // move iterator to front of list (Most Recently Used)
-        list.splice(list.begin(), list, map[lineIndex]);
+        set.lruList.splice(set.lruList.begin(), set.lruList, set.lruPos[lineIndex]);
     }
 }
 
-int Cache::getVictimIndex(int setIndex)
+int Cache::getVictimIndex(CacheSet &set)
 {
     if (isLRU)
     {
-        return lruLists[setIndex].back(); // LRU is at back
+        return set.lruList.back(); // LRU is at back
     }
     else
     {
-        return fifoNextVictim[setIndex];
+        return set.fifoNextVictim;
     }
 }
 
-void Cache::updatePolicyOnReplace(int setIndex, int lineIndex)
+void Cache::updatePolicyOnReplace(CacheSet &set, int lineIndex)
 {
     if (isLRU)
     {
-        updatePolicyOnHit(setIndex, lineIndex);
+        updatePolicyOnHit(set, lineIndex);
     }
     else
     {
-        fifoNextVictim[setIndex] = (fifoNextVictim[setIndex] + 1) % associativity;
+        set.fifoNextVictim = (set.fifoNextVictim + 1) % associativity;
     }
 }
 
+bool Cache::lastHitWasPrefetched() const { return lastPrefetchHit; }
+bool Cache::lastEviction(uint64_t &blockAddr) const
+{
+    blockAddr = lastVictimBlock;
+    return lastVictimValid;
+}
+const Cache::PrefetchStats &Cache::getPrefetchStats() const { return prefetch; }
+size_t Cache::getBlockSize() const { return blockSize; }
+
+size_t Cache::getSize() const
+{
+    return numSets * blockSize * associativity;
+}
+
+int Cache::getAssociativity() const
+{
+    return associativity;
+}
+
+size_t Cache::getNumSets() const
+{
+    return numSets;
+}
+
+size_t Cache::getTouchedSets() const
+{
+    return touchedSets;
+}
+
+bool Cache::usesLRU() const
+{
+    return isLRU;
+}
 uint64_t Cache::getHits() const { return hits; }
 uint64_t Cache::getMisses() const { return misses; }
 double Cache::getHitRate() const
@@ -175,14 +434,133 @@ double Cache::getHitRate() const
     return (hits + misses) == 0 ? 0.0 : (double)hits / (hits + misses);
 }
 
+void Cache::registerStats(stats::Registry &registry, const std::string &prefix)
+{
+    statHits = registry.counter(prefix + ".hits");
+    statMisses = registry.counter(prefix + ".misses");
+    statEvictions = registry.counter(prefix + ".evictions");
+    statDirtyEvictions = registry.counter(prefix + ".dirty_evictions");
+    statSetMisses = registry.counterArray(prefix + ".set_misses", numSets);
+    statSetConflictMisses = registry.counterArray(prefix + ".set_conflict_misses", numSets);
+    statPrefetchFills = registry.counter(prefix + ".prefetch_fills");
+    statPrefetchUseful = registry.counter(prefix + ".prefetch_useful");
+    statPrefetchPollution = registry.counter(prefix + ".prefetch_pollution");
+}
+
+void Cache::save(CheckpointWriter &out) const
+{
+    out.put<uint64_t>(numSets);
+    out.put<uint64_t>(blockSize);
+    out.put<int32_t>(associativity);
+    out.put<uint8_t>(isLRU);
+    out.put<uint64_t>(hits);
+    out.put<uint64_t>(misses);
+    // untouched sets are left out and come back untouched
+    out.put<uint64_t>(touchedSets);
+    for (size_t i = 0; i < numSets; i++)
+    {
+        if (!sets[i])
+            continue;
+        out.put<uint64_t>(i);
+        for (const auto &line : sets[i]->lines)
+        {
+            out.put<uint8_t>(line.valid | (line.modified << 1) | (line.prefetched << 2));
+            out.put<uint64_t>(line.tag);
+            out.put<uint64_t>(line.phyAddr);
+        }
+        if (associativity == 1)
+            continue;
+        if (isLRU)
+        {
+            for (int way : sets[i]->lruList)
+                out.put<int32_t>(way);
+        }
+        else
+        {
+            out.put<int32_t>(sets[i]->fifoNextVictim);
+        }
+    }
+}
+
+std::unique_ptr<Cache> Cache::restore(CheckpointReader &in)
+{
+    uint64_t nSets = in.get<uint64_t>();
+    uint64_t bSize = in.get<uint64_t>();
+    int32_t assoc = in.get<int32_t>();
+    bool lru = in.get<uint8_t>();
+    if (!in.ok() || nSets == 0 || (nSets & (nSets - 1)) || bSize == 0 || (bSize & (bSize - 1)) ||
+        assoc < 1 || nSets > SIZE_MAX / bSize / assoc)
+    {
+        in.fail("corrupt cache geometry");
+        return nullptr;
+    }
+    auto cache = std::make_unique<Cache>(nSets * bSize * assoc, bSize, assoc, lru);
+    cache->hits = in.get<uint64_t>();
+    cache->misses = in.get<uint64_t>();
+    const size_t lineBytes = 1 + 2 * sizeof(uint64_t);
+    uint64_t touched = in.getCount(sizeof(uint64_t) + assoc * lineBytes);
+    for (uint64_t s = 0; s < touched && in.ok(); s++)
+    {
+        uint64_t index = in.get<uint64_t>();
+        if (index >= nSets || cache->sets[index])
+        {
+            in.fail("corrupt cache set index");
+            return nullptr;
+        }
+        CacheSet &set = cache->materialize(index);
+        for (auto &line : set.lines)
+        {
+            uint8_t flags = in.get<uint8_t>();
+            line.valid = flags & 1;
+            line.modified = flags & 2;
+            line.prefetched = flags & 4;
+            line.tag = in.get<uint64_t>();
+            line.phyAddr = in.get<uint64_t>();
+        }
+        if (assoc == 1)
+            continue;
+        if (lru)
+        {
+            set.lruList.clear();
+            std::vector<bool> placed(assoc, false);
+            for (int j = 0; j < assoc; j++)
+            {
+                int32_t way = in.get<int32_t>();
+                if (way < 0 || way >= assoc || placed[way])
+                {
+                    in.fail("corrupt LRU order");
+                    return nullptr;
+                }
+                placed[way] = true;
+                set.lruPos[way] = set.lruList.insert(set.lruList.end(), way);
+            }
+        }
+        else
+        {
+            int32_t next = in.get<int32_t>();
+            if (next < 0 || next >= assoc)
+            {
+                in.fail("corrupt FIFO pointer");
+                return nullptr;
+            }
+            set.fifoNextVictim = next;
+        }
+    }
+    if (!in.ok())
+        return nullptr;
+    return cache;
+}
+
 void Cache::dump() const
 {
     std::cout << "--- Cache Dump ---" << std::endl;
     for (size_t i = 0; i < numSets; i++)
     {
+        if (!sets[i])
+            continue;
         for (int j = 0; j < associativity; j++)
         {
-            const auto &line = sets[i].lines[j];
+            const auto &line = sets[i]->lines[j];
             if (line.valid)
             {
                 if (line.modified)
@@ -208,34 +586,195 @@ cacheHierarchy::cacheHierarchy(Cache *c1, Cache *c2)
     : l1Cache(c1), l2Cache(c2)
 {
 }
+void cacheHierarchy::registerStats(stats::Registry &registry)
+{
+    l1Cache->registerStats(registry, "l1");
+    l2Cache->registerStats(registry, "l2");
+}
+
+void cacheHierarchy::attachPrefetcher(int level, std::unique_ptr<Prefetcher> prefetcher, uint64_t latency)
+{
+    PrefetchPort &port = ports[level == 1 ? 0 : 1];
+    port = PrefetchPort();
+    port.prefetcher = std::move(prefetcher);
+    port.latency = latency;
+}
+
+void cacheHierarchy::attachVictimCache(size_t entries)
+{
+    victimCache.reset(entries ? new VictimCache(entries) : nullptr);
+}
+
+void cacheHierarchy::attachMSHR(size_t entries, uint64_t latency)
+{
+    mshr.reset(entries ? new MSHRFile(entries, latency) : nullptr);
+}
+
 void cacheHierarchy::access(uint64_t physicalAddress, bool write)
 {
-    if (!(l1Cache->access(physicalAddress, write)))
+    tick++;
+    if (!ports[0].prefetcher && !ports[1].prefetcher && !victimCache && !mshr)
+    {
+        if (!(l1Cache->access(physicalAddress, write)))
+        {
+            l2Cache->access(physicalAddress, write);
+        }
+        return;
+    }
+
+    uint64_t block = physicalAddress & ~(uint64_t)(l1Cache->getBlockSize() - 1);
+    drainPrefetches(ports[0], l1Cache);
+    drainPrefetches(ports[1], l2Cache);
+    bool l1Hit = l1Cache->access(physicalAddress, write);
+    trainPrefetcher(ports[0], l1Cache, physicalAddress, l1Hit);
+    if (l1Hit)
+        return;
+
+    if (victimCache)
     {
-        l2Cache->access(physicalAddress, write);
+        // swap: the requested block leaves the victim cache, L1's victim enters it
+        bool victimHit = victimCache->extract(block);
+        uint64_t evicted;
+        if (l1Cache->lastEviction(evicted))
+            victimCache->insert(evicted);
+        if (victimHit)
+            return;
     }
+    if (mshr)
+    {
+        // the line is still being fetched: merge into the outstanding miss
+        if (mshr->merge(block, tick))
+            return;
+        mshr->allocate(block, tick);
+    }
+    bool l2Hit = l2Cache->access(physicalAddress, write);
+    trainPrefetcher(ports[1], l2Cache, physicalAddress, l2Hit);
 }
 
-void cacheHierarchy::stats()
+void cacheHierarchy::accessBatch(const uint64_t *physicalAddresses, const bool *writes, size_t count)
+{
+    if (ports[0].prefetcher || ports[1].prefetcher || victimCache || mshr)
+    {
+        for (size_t i = 0; i < count; i++)
+            access(physicalAddresses[i], writes[i]);
+        return;
+    }
+    // L1 never looks at L2, so L2 can take a block's misses after L1 is done
+    bool l1Hits[BATCH_CHUNK];
+    uint64_t missAddrs[BATCH_CHUNK];
+    bool missWrites[BATCH_CHUNK];
+    for (size_t base = 0; base < count; base += BATCH_CHUNK)
+    {
+        size_t n = std::min(BATCH_CHUNK, count - base);
+        l1Cache->accessBatch(physicalAddresses + base, writes + base, n, l1Hits);
+        size_t misses = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            if (!l1Hits[i])
+            {
+                missAddrs[misses] = physicalAddresses[base + i];
+                missWrites[misses++] = writes[base + i];
+            }
+        }
+        l2Cache->accessBatch(missAddrs, missWrites, misses, nullptr);
+    }
+    tick += count;
+}
+
+void cacheHierarchy::warm(uint64_t physicalAddress, bool write)
+{
+    if (!l1Cache->warm(physicalAddress, write))
+        l2Cache->warm(physicalAddress, write);
+}
+
+void cacheHierarchy::drainPrefetches(PrefetchPort &port, Cache *cache)
+{
+    while (!port.inFlight.empty() && port.inFlight.front().second <= tick)
+    {
+        uint64_t block = port.inFlight.front().first;
+        port.inFlight.pop_front();
+        if (port.inFlightBlocks.erase(block))
+            cache->prefetchFill(block);
+    }
+}
+
+void cacheHierarchy::trainPrefetcher(PrefetchPort &port, Cache *cache, uint64_t physicalAddress, bool hit)
+{
+    if (!port.prefetcher)
+        return;
+    uint64_t block = physicalAddress & ~(uint64_t)(cache->getBlockSize() - 1);
+    // demand caught up with a prefetch still in flight: it was issued too late
+    if (!hit && port.inFlightBlocks.erase(block))
+        port.late++;
+
+    port.candidates.clear();
+    port.prefetcher->observe(block, hit, cache->lastHitWasPrefetched(), port.candidates);
+    for (uint64_t candidate : port.candidates)
+    {
+        if (cache->contains(candidate) || port.inFlightBlocks.count(candidate))
+        {
+            port.redundant++;
+            continue;
+        }
+        port.issued++;
+        if (port.latency == 0)
+        {
+            cache->prefetchFill(candidate);
+        }
+        else
+        {
+            port.inFlight.push_back({candidate, tick + port.latency});
+            port.inFlightBlocks.insert(candidate);
+        }
+    }
+}
+
+void cacheHierarchy::printPrefetchStats(const char *name, const PrefetchPort &port, const Cache *cache) const
+{
+    const Cache::PrefetchStats &p = cache->getPrefetchStats();
+    uint64_t useful = p.useful;
+    double accuracy = port.issued == 0 ? 0 : (double)useful / port.issued;
+    double coverage = (useful + cache->getMisses()) == 0 ? 0 : (double)useful / (useful + cache->getMisses());
+    double timeliness = (useful + port.late) == 0 ? 0 : (double)useful / (useful + port.late);
+    std::cout << "\n" << name << " Prefetcher (" << port.prefetcher->name() << "):\n";
+    std::cout << "  Issued:           " << port.issued << " (" << port.redundant << " redundant dropped)\n";
+    std::cout << "  Useful:           " << useful << " | Late: " << port.late << " | Unused evicted: " << p.unused << "\n";
+    std::cout << "  Accuracy:         " << accuracy * 100 << "%\n";
+    std::cout << "  Coverage:         " << coverage * 100 << "%\n";
+    std::cout << "  Timeliness:       " << timeliness * 100 << "%\n";
+    std::cout << "  Pollution Misses: " << p.pollution << "\n";
+}
+
+namespace
 {
     // Constants for cycles
     const int L1_HIT_TIME = 1;
     const int L2_HIT_TIME = 10;
     const int RAM_ACCESS_TIME = 100;
+}
 
-    uint64_t l1Hits = l1Cache->getHits();
-    uint64_t l1Misses = l1Cache->getMisses();
-    uint64_t totalAccesses = l1Hits + l1Misses;
-
-    double l1MissRate = (totalAccesses == 0) ? 0 : (double)l1Misses / totalAccesses;
-    double l2MissRateLocal = (l2Cache->getHits() + l2Cache->getMisses() == 0) ? 0
-                                                                              : (double)l2Cache->getMisses() / (l2Cache->getHits() + l2Cache->getMisses());
+double cacheHierarchy::missPenalty() const
+{
+    uint64_t l2Accesses = l2Cache->getHits() + l2Cache->getMisses();
+    double l2MissRateLocal = (l2Accesses == 0) ? 0 : (double)l2Cache->getMisses() / l2Accesses;
+    // L1 Miss Penalty: L2_Hit + (L2_Miss_Rate * RAM_Time)
+    return L2_HIT_TIME + (l2MissRateLocal * RAM_ACCESS_TIME);
+}
 
-    // Calculate L1 Miss Penalty: L2_Hit + (L2_Miss_Rate * RAM_Time)
-    double l1MissPenalty = L2_HIT_TIME + (l2MissRateLocal * RAM_ACCESS_TIME);
+double cacheHierarchy::averageAccessTime() const
+{
+    uint64_t totalAccesses = l1Cache->getHits() + l1Cache->getMisses();
+    double l1MissRate = (totalAccesses == 0) ? 0 : (double)l1Cache->getMisses() / totalAccesses;
+    // AAT: L1_Hit + (L1_Miss_Rate * L1_Miss_Penalty)
+    return L1_HIT_TIME + (l1MissRate * missPenalty());
+}
 
-    // Calculate AAT: L1_Hit + (L1_Miss_Rate * L1_Miss_Penalty)
-    double aat = L1_HIT_TIME + (l1MissRate * l1MissPenalty);
+void cacheHierarchy::stats()
+{
+    uint64_t l1Hits = l1Cache->getHits();
+    uint64_t l1Misses = l1Cache->getMisses();
+    double l1MissPenalty = missPenalty();
+    double aat = averageAccessTime();
 
     std::cout << "\n========== Hierarchical Stats ==========\n";
     std::cout << "L1 Cache:\n";
@@ -247,6 +786,33 @@ void cacheHierarchy::stats()
     std::cout << "  Hits:             " << l2Cache->getHits() << "\n";
     std::cout << "  Misses:           " << l2Cache->getMisses() << "\n";
     std::cout << "  Local Hit Rate:   " << l2Cache->getHitRate() * 100 << "%\n";
+    if (const Cache::MissTypes *types = l2Cache->getMissTypes())
+    {
+        std::cout << "  Compulsory:       " << types->compulsory << "\n";
+        std::cout << "  Capacity:         " << types->capacity << "\n";
+        std::cout << "  Conflict:         " << types->conflict << "\n";
+    }
+
+    if (victimCache)
+    {
+        std::cout << "\nVictim Cache (" << victimCache->capacity() << " entries):\n";
+        std::cout << "  Hits:             " << victimCache->hits << "\n";
+        std::cout << "  Misses:           " << victimCache->misses << "\n";
+        std::cout << "  L2 Accesses Saved: " << victimCache->hits << "\n";
+    }
+    if (mshr)
+    {
+        std::cout << "\nMSHR (" << mshr->capacity() << " entries, latency " << mshr->getLatency() << "):\n";
+        std::cout << "  Primary Misses:   " << mshr->primary << "\n";
+        std::cout << "  Merged Misses:    " << mshr->merged << "\n";
+        std::cout << "  Full Stalls:      " << mshr->stalls << " (" << mshr->stallCycles << " access slots)\n";
+        std::cout << "  Peak Occupancy:   " << mshr->peakOccupancy << "\n";
+        std::cout << "  L2 Accesses Saved: " << mshr->merged << "\n";
+    }
+    if (ports[0].prefetcher)
+        printPrefetchStats("L1", ports[0], l1Cache);
+    if (ports[1].prefetcher)
+        printPrefetchStats("L2", ports[1], l2Cache);
 
     std::cout << "\nPerformance Metrics:\n";
     std::cout << "  L1 Miss Penalty:  " << l1MissPenalty << " cycles\n";
@@ -0,0 +1,143 @@
+#include "checkpoint.h"
+#include <fstream>
+#include <iterator>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    const char MAGIC[8] = {'M', 'S', 'I', 'M', 'C', 'K', 'P', 'T'};
+    const uint32_t VERSION = 3;
+    const size_t HEADER_SIZE = sizeof(MAGIC) + 2 * sizeof(uint32_t);
+}
+
+const char *checkpointKindName(CheckpointKind kind)
+{
+    switch (kind)
+    {
+    case CheckpointKind::Allocator:
+        return "Allocator";
+    case CheckpointKind::Cache:
+        return "Cache";
+    case CheckpointKind::VirtualMemory:
+        return "VM";
+    case CheckpointKind::Integrated:
+        return "Integrated";
+    }
+    return "Unknown";
+}
+
+bool CheckpointWriter::writeFile(const std::string &path, CheckpointKind kind) const
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+        return false;
+    uint32_t version = VERSION;
+    uint32_t k = static_cast<uint32_t>(kind);
+    out.write(MAGIC, sizeof(MAGIC));
+    out.write(reinterpret_cast<const char *>(&version), sizeof(version));
+    out.write(reinterpret_cast<const char *>(&k), sizeof(k));
+    out.write(buffer.data(), buffer.size());
+    return (bool)out;
+}
+
+CheckpointReader::~CheckpointReader()
+{
+#ifndef _WIN32
+    if (mapped)
+        munmap(const_cast<char *>(data), size);
+#endif
+}
+
+bool CheckpointReader::open(const std::string &path)
+{
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        fail("could not open " + path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED)
+        {
+            data = static_cast<const char *>(p);
+            size = st.st_size;
+            mapped = true;
+        }
+    }
+    ::close(fd);
+#endif
+    if (!mapped)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+        {
+            fail("could not open " + path);
+            return false;
+        }
+        fallback.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        data = fallback.data();
+        size = fallback.size();
+    }
+
+    if (size < HEADER_SIZE || std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0)
+    {
+        fail("not a memsim checkpoint");
+        return false;
+    }
+    pos = sizeof(MAGIC);
+    uint32_t version = get<uint32_t>();
+    if (version != VERSION)
+    {
+        fail("unsupported checkpoint version " + std::to_string(version));
+        return false;
+    }
+    fileKind = static_cast<CheckpointKind>(get<uint32_t>());
+    return ok();
+}
+
+CheckpointKind CheckpointReader::kind() const
+{
+    return fileKind;
+}
+
+uint64_t CheckpointReader::getCount(size_t minElementSize)
+{
+    uint64_t count = get<uint64_t>();
+    if (minElementSize > 0 && count > (size - pos) / minElementSize)
+    {
+        fail("corrupt element count");
+        return 0;
+    }
+    return count;
+}
+
+size_t CheckpointReader::remaining() const
+{
+    return size - pos;
+}
+
+bool CheckpointReader::ok() const
+{
+    return !failed;
+}
+
+const std::string &CheckpointReader::error() const
+{
+    return message;
+}
+
+void CheckpointReader::fail(const std::string &msg)
+{
+    if (!failed)
+        message = msg;
+    failed = true;
+}
@@ -0,0 +1,330 @@
+#include "generators.h"
+#include <cmath>
+#include <algorithm>
+#include <sstream>
+
+Generator::Generator(uint64_t count, int writePercent_, uint64_t seed)
+    : rng(seed), remaining(count), writePercent(writePercent_)
+{
+}
+
+void Generator::setPid(int pid_)
+{
+    pid = pid_;
+}
+
+bool Generator::next(TraceRecord &rec)
+{
+    if (remaining == 0)
+        return false;
+    remaining--;
+    bool write = writePercent > 0 && (int)rng.below(100) < writePercent;
+    rec.addr = nextAddress(write);
+    rec.pid = pid;
+    rec.write = write;
+    return true;
+}
+
+SequentialGenerator::SequentialGenerator(uint64_t count, uint64_t stride_, uint64_t footprint_, int writePercent)
+    : Generator(count, writePercent, 1), stride(stride_), footprint(footprint_)
+{
+}
+
+uint64_t SequentialGenerator::nextAddress(bool &)
+{
+    uint64_t addr = pos;
+    pos += stride;
+    if (pos >= footprint)
+        pos = 0;
+    return addr;
+}
+
+UniformGenerator::UniformGenerator(uint64_t count, uint64_t footprint, uint64_t align_, int writePercent, uint64_t seed)
+    : Generator(count, writePercent, seed), slots(footprint / align_), align(align_)
+{
+}
+
+uint64_t UniformGenerator::nextAddress(bool &)
+{
+    return rng.below(slots) * align;
+}
+
+namespace
+{
+    double zeta(uint64_t n, double theta)
+    {
+        double sum = 0.0;
+        for (uint64_t i = 1; i <= n; i++)
+            sum += 1.0 / std::pow((double)i, theta);
+        return sum;
+    }
+}
+
+ZipfGenerator::ZipfGenerator(uint64_t count, uint64_t items_, double theta_, uint64_t itemSize_, int writePercent, uint64_t seed)
+    : Generator(count, writePercent, seed), items(items_), itemSize(itemSize_), theta(theta_)
+{
+    zetan = zeta(items, theta);
+    double zeta2 = zeta(2, theta);
+    alpha = 1.0 / (1.0 - theta);
+    eta = (1.0 - std::pow(2.0 / items, 1.0 - theta)) / (1.0 - zeta2 / zetan);
+    halfPowTheta = 1.0 + std::pow(0.5, theta);
+}
+
+uint64_t ZipfGenerator::nextAddress(bool &)
+{
+    double u = rng.unit();
+    double uz = u * zetan;
+    uint64_t rank;
+    if (uz < 1.0)
+        rank = 0;
+    else if (uz < halfPowTheta)
+        rank = 1;
+    else
+        rank = (uint64_t)(items * std::pow(eta * u - eta + 1.0, alpha));
+    if (rank >= items)
+        rank = items - 1;
+    return rank * itemSize;
+}
+
+PointerChaseGenerator::PointerChaseGenerator(uint64_t count, uint64_t nodes, uint64_t nodeSize_, uint64_t seed)
+    : Generator(count, 0, seed), successor(nodes), nodeSize(nodeSize_)
+{
+    // Sattolo's algorithm: a uniformly random permutation with one cycle
+    std::vector<uint64_t> order(nodes);
+    for (uint64_t k = 0; k < nodes; k++)
+        order[k] = k;
+    for (uint64_t k = nodes - 1; k > 0; k--)
+        std::swap(order[k], order[rng.below(k)]);
+    for (uint64_t k = 0; k < nodes; k++)
+        successor[order[k]] = order[(k + 1) % nodes];
+}
+
+uint64_t PointerChaseGenerator::nextAddress(bool &)
+{
+    uint64_t addr = current * nodeSize;
+    current = successor[current];
+    return addr;
+}
+
+MatMulGenerator::MatMulGenerator(uint64_t count, uint64_t n_, uint64_t tile_, uint64_t elemSize_)
+    : Generator(count, 0, 1), n(n_), tile(tile_ > n_ ? n_ : tile_), elemSize(elemSize_)
+{
+}
+
+uint64_t MatMulGenerator::element(uint64_t matrix, uint64_t row, uint64_t col) const
+{
+    return ((matrix * n + row) * n + col) * elemSize;
+}
+
+uint64_t MatMulGenerator::nextAddress(bool &write)
+{
+    // the k loop is clipped at the matrix edge for partial tiles
+    uint64_t kTile = std::min(tile, n - kk);
+    uint64_t addr;
+    write = false;
+    if (step == 0)
+    {
+        addr = element(2, i, j);
+    }
+    else if (step <= 2 * kTile)
+    {
+        uint64_t k = kk + (step - 1) / 2;
+        addr = (step % 2) ? element(0, i, k) : element(1, k, j);
+    }
+    else
+    {
+        addr = element(2, i, j);
+        write = true;
+    }
+    if (++step > 2 * kTile + 1)
+    {
+        step = 0;
+        advance();
+    }
+    return addr;
+}
+
+void MatMulGenerator::advance()
+{
+    // j, i inside the (ii, jj, kk) tile, then kk, jj, ii
+    if (++j < std::min(jj + tile, n))
+        return;
+    j = jj;
+    if (++i < std::min(ii + tile, n))
+        return;
+    i = ii;
+    kk += tile;
+    if (kk < n)
+        return;
+    kk = 0;
+    jj += tile;
+    if (jj >= n)
+    {
+        jj = 0;
+        ii += tile;
+        if (ii >= n)
+            ii = 0;
+    }
+    i = ii;
+    j = jj;
+}
+
+ScanHotGenerator::ScanHotGenerator(uint64_t count, uint64_t hot_, uint64_t scan_, uint64_t stride_, int hotPercent_, uint64_t seed)
+    : Generator(count, 0, seed), hot(hot_), scan(scan_), stride(stride_), hotPercent(hotPercent_)
+{
+}
+
+uint64_t ScanHotGenerator::nextAddress(bool &)
+{
+    if ((int)rng.below(100) < hotPercent)
+        return rng.below(hot / 8) * 8;
+    uint64_t addr = hot + pos;
+    pos += stride;
+    if (pos >= scan)
+        pos = 0;
+    return addr;
+}
+
+MixGenerator::MixGenerator(std::vector<std::unique_ptr<Generator>> streams_, uint64_t burst_)
+    : streams(std::move(streams_)), burst(burst_ == 0 ? 1 : burst_)
+{
+}
+
+bool MixGenerator::next(TraceRecord &rec)
+{
+    for (size_t tried = 0; tried < streams.size(); tried++)
+    {
+        if (inBurst == burst)
+        {
+            inBurst = 0;
+            current = (current + 1) % streams.size();
+        }
+        if (streams[current]->next(rec))
+        {
+            inBurst++;
+            return true;
+        }
+        inBurst = burst; // exhausted: move on
+    }
+    return false;
+}
+
+namespace
+{
+    const char *USAGE =
+        "Usage: gen seq <count> <stride> <footprint> [write%]\n"
+        "       gen uniform <count> <footprint> [write%] [seed]\n"
+        "       gen zipf <count> <items> <theta> [itemSize] [write%] [seed]\n"
+        "       gen chase <count> <nodes> <nodeSize> [seed]\n"
+        "       gen matmul <count> <n> <tile> [elemSize]\n"
+        "       gen scan <count> <hot> <scan> <stride> <hot%> [seed]\n"
+        "       gen mix <count> <pids> <burst> <kind> <params...>";
+
+    // Trailing parameters keep their default when absent
+    template <typename T>
+    void optional(std::istream &in, T &value)
+    {
+        T parsed;
+        if (in >> parsed)
+            value = parsed;
+    }
+
+    // Builds one stream from the parameters that follow <count>
+    std::unique_ptr<Generator> makeStream(const std::string &kind, uint64_t count, std::istream &in, uint64_t seedOffset)
+    {
+        uint64_t a = 0, b = 0, c = 0, seed = 1;
+        int write = 0;
+        std::unique_ptr<Generator> gen;
+        if (kind == "seq")
+        {
+            if (!(in >> a >> b) || a == 0 || b == 0)
+                return nullptr;
+            optional(in, write);
+            gen = std::make_unique<SequentialGenerator>(count, a, b, write);
+        }
+        else if (kind == "uniform")
+        {
+            if (!(in >> a) || a < 8)
+                return nullptr;
+            optional(in, write);
+            optional(in, seed);
+            gen = std::make_unique<UniformGenerator>(count, a, 8, write, seed + seedOffset);
+        }
+        else if (kind == "zipf")
+        {
+            double theta;
+            c = 64;
+            if (!(in >> a >> theta) || a < 2 || !(theta > 0.0 && theta < 1.0))
+                return nullptr;
+            optional(in, c);
+            optional(in, write);
+            optional(in, seed);
+            if (c == 0)
+                return nullptr;
+            gen = std::make_unique<ZipfGenerator>(count, a, theta, c, write, seed + seedOffset);
+        }
+        else if (kind == "chase")
+        {
+            if (!(in >> a >> b) || a < 2 || b == 0)
+                return nullptr;
+            optional(in, seed);
+            gen = std::make_unique<PointerChaseGenerator>(count, a, b, seed + seedOffset);
+        }
+        else if (kind == "matmul")
+        {
+            c = 8;
+            if (!(in >> a >> b) || a == 0 || b == 0)
+                return nullptr;
+            optional(in, c);
+            if (c == 0)
+                return nullptr;
+            gen = std::make_unique<MatMulGenerator>(count, a, b, c);
+        }
+        else if (kind == "scan")
+        {
+            int hotPercent;
+            if (!(in >> a >> b >> c >> hotPercent) || a < 8 || c == 0 || b < c || hotPercent < 0 || hotPercent > 100)
+                return nullptr;
+            optional(in, seed);
+            gen = std::make_unique<ScanHotGenerator>(count, a, b, c, hotPercent, seed + seedOffset);
+        }
+        if (gen && (write < 0 || write > 100))
+            return nullptr;
+        return gen;
+    }
+}
+
+std::unique_ptr<TraceSource> makeGenerator(std::istream &args, std::string &error)
+{
+    std::string kind;
+    uint64_t count;
+    error = USAGE;
+    if (!(args >> kind >> count))
+        return nullptr;
+    if (kind != "mix")
+    {
+        auto gen = makeStream(kind, count, args, 0);
+        if (gen)
+            error.clear();
+        return gen;
+    }
+
+    uint64_t pids, burst;
+    std::string inner, rest;
+    if (!(args >> pids >> burst >> inner) || pids == 0 || inner == "mix")
+        return nullptr;
+    std::getline(args, rest);
+    std::vector<std::unique_ptr<Generator>> streams;
+    for (uint64_t p = 0; p < pids; p++)
+    {
+        // every pid replays the same parameters with its own seed
+        std::stringstream params(rest);
+        auto gen = makeStream(inner, count / pids + (p < count % pids ? 1 : 0), params, p);
+        if (!gen)
+            return nullptr;
+        gen->setPid((int)p + 1);
+        streams.push_back(std::move(gen));
+    }
+    error.clear();
+    return std::make_unique<MixGenerator>(std::move(streams), burst);
+}
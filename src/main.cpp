@@ -6,10 +6,25 @@
 #include <memory>
 #include <limits>
 #include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <map>
+#include <iomanip>
 
 #include "allocator.h"
+#include "bitmap.h"
 #include "cache.h"
 #include "virtualmemory.h"
+#include "multicore.h"
+#include "checkpoint.h"
+#include "stats.h"
+#include "sampler.h"
+#include "trace.h"
+#include "tracefile.h"
+#include "generators.h"
+#include "sweep.h"
+#include "opt.h"
+#include "replay.h"
 
 void printHeader(const std::string &title)
 {
@@ -21,6 +36,520 @@ bool isPowerOfTwo(size_t n)
     return (n > 0) && ((n & (n - 1)) == 0);
 }
 
+void writeStats(std::ostream &os, const std::string &format)
+{
+    if (format == "csv")
+        stats::global().writeCSV(os);
+    else
+        stats::global().writeJSON(os);
+}
+
+// export <json|csv> [file]: dump the metrics registry on demand (stdout if no file)
+void exportStats(std::stringstream &ss)
+{
+    std::string format, path;
+    ss >> format >> path;
+    if (format != "json" && format != "csv")
+    {
+        std::cout << "Usage: export <json|csv> [file]\n";
+        return;
+    }
+    if (path.empty())
+    {
+        writeStats(std::cout, format);
+        return;
+    }
+    std::ofstream out(path);
+    if (!out)
+    {
+        std::cout << "Error: Could not open " << path << "\n";
+        return;
+    }
+    writeStats(out, format);
+    std::cout << "Stats written to " << path << "\n";
+}
+
+// interval <N> <file|-> starts streaming snapshots, interval off stops them
+std::unique_ptr<IntervalSampler> openSampler(std::stringstream &ss)
+{
+    std::string arg, path;
+    ss >> arg;
+    if (arg == "off")
+    {
+        std::cout << "Interval sampling stopped.\n";
+        return nullptr;
+    }
+    std::stringstream num(arg);
+    uint64_t every;
+    if (!(num >> every) || every == 0 || !(ss >> path))
+    {
+        std::cout << "Usage: interval <N> <file|-> | interval off\n";
+        return nullptr;
+    }
+    auto sampler = std::make_unique<IntervalSampler>(path, every);
+    if (!sampler->isOpen())
+    {
+        std::cout << "Error: Could not open " << path << "\n";
+        return nullptr;
+    }
+    std::cout << "Sampling every " << every << " events to " << path << ".\n";
+    return sampler;
+}
+
+void addCacheColumns(IntervalSampler &sampler, std::unique_ptr<Cache> &l1, std::unique_ptr<Cache> &l2)
+{
+    sampler.addRate("l1_hit_rate", [&l1] { return l1->getHits(); },
+                    [&l1] { return l1->getHits() + l1->getMisses(); });
+    sampler.addRate("l2_hit_rate", [&l2] { return l2->getHits(); },
+                    [&l2] { return l2->getHits() + l2->getMisses(); });
+}
+
+void addPagingColumns(IntervalSampler &sampler, std::unique_ptr<PhysicalMemory> &pm)
+{
+    sampler.addRate("page_fault_rate", [&pm] { return pm->pageFaults; },
+                    [&pm] { return pm->pageFaults + pm->pageHits; });
+    sampler.addGauge("frames_used", [&pm] { return (double)pm->framesInUse(); });
+}
+
+// prefetch <l1|l2> <none|next|stride|corr> [degree] [latency]
+void configurePrefetch(std::stringstream &ss, cacheHierarchy &hierarchy, const Cache &cache)
+{
+    std::string level, kind;
+    int degree = 1;
+    uint64_t latency = 0;
+    if (!(ss >> level >> kind) || (level != "l1" && level != "l2"))
+    {
+        std::cout << "Usage: prefetch <l1|l2> <none|next|stride|corr> [degree] [latency]\n";
+        return;
+    }
+    ss >> degree >> latency;
+    int lvl = (level == "l1") ? 1 : 2;
+    if (kind == "none")
+    {
+        hierarchy.attachPrefetcher(lvl, nullptr, 0);
+        std::cout << "Prefetcher removed from " << level << ".\n";
+        return;
+    }
+    auto prefetcher = makePrefetcher(kind, cache.getBlockSize(), degree);
+    if (!prefetcher)
+    {
+        std::cout << "Error: Unknown prefetcher '" << kind << "'.\n";
+        return;
+    }
+    std::cout << "Attached " << prefetcher->name() << " prefetcher to " << level
+              << " (degree " << degree << ", latency " << latency << ").\n";
+    hierarchy.attachPrefetcher(lvl, std::move(prefetcher), latency);
+}
+
+// victim <entries> | mshr <entries> <latency>; 0 entries removes the structure
+void configureMissBuffers(const std::string &cmd, std::stringstream &ss, cacheHierarchy &hierarchy)
+{
+    size_t entries;
+    uint64_t latency = 0;
+    if (cmd == "victim")
+    {
+        if (!(ss >> entries))
+        {
+            std::cout << "Usage: victim <entries>\n";
+            return;
+        }
+        hierarchy.attachVictimCache(entries);
+        if (entries)
+            std::cout << "Victim cache enabled (" << entries << " entries).\n";
+        else
+            std::cout << "Victim cache disabled.\n";
+        return;
+    }
+    if (!(ss >> entries >> latency))
+    {
+        std::cout << "Usage: mshr <entries> <latency>\n";
+        return;
+    }
+    hierarchy.attachMSHR(entries, latency);
+    if (entries)
+        std::cout << "MSHR enabled (" << entries << " entries, latency " << latency << ").\n";
+    else
+        std::cout << "MSHR disabled.\n";
+}
+
+// swap <readLatency> <writeLatency> <queueDepth> | swap off
+void configureSwap(std::stringstream &ss, PhysicalMemory &pm)
+{
+    std::string arg;
+    uint64_t readLatency, writeLatency;
+    size_t depth;
+    ss >> arg;
+    if (arg == "off")
+    {
+        pm.attachSwap(nullptr);
+        std::cout << "Swap device detached.\n";
+        return;
+    }
+    std::stringstream num(arg);
+    if (!(num >> readLatency) || !(ss >> writeLatency >> depth) || depth == 0)
+    {
+        std::cout << "Usage: swap <readLatency> <writeLatency> <queueDepth> | swap off\n";
+        return;
+    }
+    pm.attachSwap(std::make_unique<SwapDevice>(readLatency, writeLatency, depth));
+    std::cout << "Swap device attached (read " << readLatency << ", write " << writeLatency << ", depth " << depth << ").\n";
+}
+
+// curve on [maxFrames] | curve off | curve | curve csv <file|->
+void configureCurve(std::stringstream &ss, PhysicalMemory &pm)
+{
+    std::string arg;
+    ss >> arg;
+    if (arg == "on")
+    {
+        // FIFO is simulated at powers of two up to maxFrames (default 4x RAM)
+        size_t maxFrames = 4 * (pm.ramSize() / pm.pagesize);
+        std::string extra;
+        if (ss >> extra)
+        {
+            std::stringstream num(extra);
+            if (!(num >> maxFrames) || maxFrames == 0)
+            {
+                std::cout << "Usage: curve on [maxFrames]\n";
+                return;
+            }
+        }
+        pm.attachCurve(std::make_unique<FaultCurve>(maxFrames));
+        std::cout << "Fault curve recording started (FIFO up to " << maxFrames << " frames).\n";
+        return;
+    }
+    if (arg == "off")
+    {
+        pm.attachCurve(nullptr);
+        std::cout << "Fault curve recording stopped.\n";
+        return;
+    }
+    if (!arg.empty() && arg != "csv")
+    {
+        std::cout << "Usage: curve on [maxFrames] | curve off | curve | curve csv <file|->\n";
+        return;
+    }
+    FaultCurve *curve = pm.faultCurve();
+    if (!curve)
+    {
+        std::cout << "Error: Run 'curve on' first.\n";
+        return;
+    }
+    if (arg.empty())
+    {
+        curve->print(std::cout);
+        return;
+    }
+    std::string path;
+    if (!(ss >> path))
+    {
+        std::cout << "Usage: curve csv <file|->\n";
+        return;
+    }
+    if (path == "-")
+    {
+        curve->writeCsv(std::cout);
+        return;
+    }
+    std::ofstream out(path);
+    if (!out)
+    {
+        std::cout << "Error: Could not open " << path << "\n";
+        return;
+    }
+    curve->writeCsv(out);
+    std::cout << "Fault curve written to " << path << "\n";
+}
+
+// color on | color off: page coloring from the L2 geometry. Either form also
+// starts the L2 miss breakdown, so runs with and without coloring compare.
+void configureColoring(std::stringstream &ss, PhysicalMemory &pm, Cache &l2)
+{
+    std::string arg;
+    if (!(ss >> arg) || (arg != "on" && arg != "off"))
+    {
+        std::cout << "Usage: color <on|off>\n";
+        return;
+    }
+    size_t sets = l2.getSize() / (l2.getBlockSize() * l2.getAssociativity());
+    size_t colors = 0;
+    if (arg == "on")
+    {
+        // one color per page-sized slice of the L2 set index range
+        colors = sets * l2.getBlockSize() / pm.pagesize;
+        if (colors < 2)
+        {
+            std::cout << "Error: The L2 index (" << sets << " sets of " << l2.getBlockSize()
+                      << " bytes) does not reach above the page offset; there is only one color.\n";
+            return;
+        }
+    }
+    std::string error;
+    if (!pm.setColoring(colors, error))
+    {
+        std::cout << "Error: " << error << "\n";
+        return;
+    }
+    l2.classifyMisses(true);
+    if (colors)
+        std::cout << "Page coloring on (" << colors << " colors); classifying L2 misses.\n";
+    else
+        std::cout << "Page coloring off; classifying L2 misses.\n";
+}
+
+// mem: resident size of the simulator process (Linux /proc) and how much of
+// the lazily allocated cache sets and frame table exists
+void printMemoryUsage(const Cache *l1, const Cache *l2, const PhysicalMemory *pm)
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    uint64_t rssKB = 0, peakKB = 0;
+    while (std::getline(status, line))
+    {
+        std::stringstream fields(line);
+        std::string key;
+        fields >> key;
+        if (key == "VmRSS:")
+            fields >> rssKB;
+        else if (key == "VmHWM:")
+            fields >> peakKB;
+    }
+    std::ios format(nullptr);
+    format.copyfmt(std::cout);
+    std::cout << "--- Simulator Memory ---\n";
+    if (rssKB)
+        std::cout << std::fixed << std::setprecision(2) << "Resident: " << rssKB / 1024.0 << " MiB (peak "
+                  << peakKB / 1024.0 << " MiB)\n";
+    else
+        std::cout << "Resident: unavailable\n";
+    std::cout.copyfmt(format);
+    if (l1)
+        std::cout << "L1 Sets Allocated: " << l1->getTouchedSets() << "/" << l1->getNumSets() << "\n";
+    if (l2)
+        std::cout << "L2 Sets Allocated: " << l2->getTouchedSets() << "/" << l2->getNumSets() << "\n";
+    if (pm)
+        std::cout << "Frame Table: " << pm->allocatedFrameEntries() << "/" << pm->ramSize() / pm->pagesize
+                  << " entries allocated\n";
+}
+
+// Checkpoints hold FIFO/LRU frame state only; prints why otherwise
+bool canCheckpoint(const PhysicalMemory &pm)
+{
+    if (pm.replacement() > ReplacementKind::LRU)
+    {
+        std::cout << "Error: Checkpoints support FIFO and LRU page replacement only.\n";
+        return false;
+    }
+    if (pm.swapDevice())
+    {
+        std::cout << "Error: Checkpoints do not include swap state; run 'swap off' first.\n";
+        return false;
+    }
+    if (pm.tierCount())
+    {
+        std::cout << "Error: Checkpoints do not include memory tiers.\n";
+        return false;
+    }
+    if (pm.sharedFrames())
+    {
+        std::cout << "Error: Checkpoints do not include copy-on-write sharing.\n";
+        return false;
+    }
+    if (pm.colorCount())
+    {
+        std::cout << "Error: Checkpoints do not include page coloring; run 'color off' first.\n";
+        return false;
+    }
+    return true;
+}
+
+// exit <pid>: unmaps the process; frames nobody else maps go to the free list
+void exitProcess(int pid, ProcessMap &processes)
+{
+    auto it = processes.find(pid);
+    if (it == processes.end())
+    {
+        std::cout << "Error: No process with PID " << pid << ".\n";
+        return;
+    }
+    size_t pages = it->second->residentPages();
+    it->second->release();
+    processes.erase(it);
+    std::cout << "PID " << pid << " exited (" << pages << " resident pages unmapped).\n";
+}
+
+// fork <parent> <child>: the child shares every resident page copy-on-write
+void forkProcess(std::stringstream &ss, ProcessMap &processes)
+{
+    int parent, child;
+    if (!(ss >> parent >> child))
+    {
+        std::cout << "Usage: fork <parentPid> <childPid>\n";
+        return;
+    }
+    auto it = processes.find(parent);
+    if (it == processes.end())
+    {
+        std::cout << "Error: No process with PID " << parent << ".\n";
+        return;
+    }
+    if (processes.count(child))
+    {
+        std::cout << "Error: PID " << child << " already exists.\n";
+        return;
+    }
+    auto forked = it->second->fork(child);
+    std::cout << "Forked PID " << parent << " -> PID " << child << " (" << forked->residentPages()
+              << " pages shared copy-on-write).\n";
+    processes[child] = std::move(forked);
+}
+
+// tiers <size> <latency> <size> <latency> ... | placement <fast|interleave|slow>
+// | migrate <epoch> <pages> | migrate off
+void configureTiers(const std::string &cmd, std::stringstream &ss, PhysicalMemory &pm)
+{
+    if (cmd == "tiers")
+    {
+        std::vector<TierSpec> specs;
+        TierSpec spec;
+        std::string error;
+        while (ss >> spec.size >> spec.latency)
+            specs.push_back(spec);
+        if (specs.empty())
+        {
+            std::cout << "Usage: tiers <size> <latency> <size> <latency> ... (fastest first)\n";
+            return;
+        }
+        if (!pm.configureTiers(specs, error))
+        {
+            std::cout << "Error: " << error << "\n";
+            return;
+        }
+        std::cout << specs.size() << " memory tiers configured.\n";
+        return;
+    }
+    if (!pm.tierCount())
+    {
+        std::cout << "Error: Run 'tiers' first.\n";
+        return;
+    }
+    std::string arg;
+    ss >> arg;
+    if (cmd == "placement")
+    {
+        if (arg == "fast")
+            pm.setPlacement(Placement::Fast);
+        else if (arg == "interleave")
+            pm.setPlacement(Placement::Interleave);
+        else if (arg == "slow")
+            pm.setPlacement(Placement::Slow);
+        else
+        {
+            std::cout << "Usage: placement <fast|interleave|slow>\n";
+            return;
+        }
+        std::cout << "New pages placed: " << arg << ".\n";
+        return;
+    }
+    uint64_t epoch;
+    size_t budget;
+    if (arg == "off")
+    {
+        pm.setMigration(0, 0);
+        std::cout << "Migration disabled.\n";
+        return;
+    }
+    std::stringstream num(arg);
+    if (!(num >> epoch) || !(ss >> budget) || epoch == 0 || budget == 0)
+    {
+        std::cout << "Usage: migrate <epochAccesses> <pagesPerEpoch> | migrate off\n";
+        return;
+    }
+    pm.setMigration(epoch, budget);
+    std::cout << "Migrating up to " << budget << " pages every " << epoch << " accesses.\n";
+}
+
+// gen <kind> <count> <params...>: a synthetic stream in place of access lines
+std::unique_ptr<TraceSource> openGenerator(std::stringstream &ss)
+{
+    std::string error;
+    auto gen = makeGenerator(ss, error);
+    if (!gen)
+        std::cout << error << "\n";
+    return gen;
+}
+
+// save <file>: the caller serialises its components into `out` first
+void writeCheckpoint(const CheckpointWriter &out, const std::string &path, CheckpointKind kind)
+{
+    if (out.writeFile(path, kind))
+        std::cout << "Checkpoint saved to " << path << ".\n";
+    else
+        std::cout << "Error: Could not write " << path << "\n";
+}
+
+// load <file>: maps the checkpoint and checks it was written by this mode
+bool openCheckpoint(std::stringstream &ss, CheckpointReader &in, CheckpointKind kind)
+{
+    std::string path;
+    if (!(ss >> path))
+    {
+        std::cout << "Usage: load <file>\n";
+        return false;
+    }
+    if (!in.open(path))
+    {
+        std::cout << "Error: " << in.error() << "\n";
+        return false;
+    }
+    if (in.kind() != kind)
+    {
+        std::cout << "Error: Checkpoint was saved in " << checkpointKindName(in.kind()) << " mode.\n";
+        return false;
+    }
+    return true;
+}
+
+void saveProcesses(CheckpointWriter &out, const std::unordered_map<int, std::unique_ptr<VirtualMemory>> &processes)
+{
+    std::vector<int> pids;
+    for (const auto &p : processes)
+        pids.push_back(p.first);
+    std::sort(pids.begin(), pids.end());
+    out.put<uint64_t>(pids.size());
+    for (int pid : pids)
+        processes.at(pid)->save(out);
+}
+
+bool restoreProcesses(CheckpointReader &in, PhysicalMemory *pm, std::unordered_map<int, std::unique_ptr<VirtualMemory>> &processes)
+{
+    uint64_t count = in.getCount(sizeof(int32_t) + sizeof(uint64_t));
+    for (uint64_t i = 0; i < count && in.ok(); i++)
+    {
+        auto vm = VirtualMemory::restore(in, pm);
+        if (!vm)
+            return false;
+        int pid = vm->getPid();
+        processes[pid] = std::move(vm);
+    }
+    return in.ok();
+}
+
+// Set by --stats <file>; written once when the program terminates
+std::string statsOutputPath;
+
+void writeFinalStats()
+{
+    std::ofstream out(statsOutputPath);
+    if (!out)
+    {
+        std::cerr << "Could not write stats to: " << statsOutputPath << std::endl;
+        return;
+    }
+    bool csv = statsOutputPath.size() >= 4 && statsOutputPath.compare(statsOutputPath.size() - 4, 4, ".csv") == 0;
+    writeStats(out, csv ? "csv" : "json");
+}
+
 
 void runAllocatorCLI()
 {
@@ -28,8 +557,19 @@ void runAllocatorCLI()
     std::cout << "[Cmds: init <size>, mode <first|best|worst>, malloc <size>, free <id>, stats, dump, back]" << std::endl;
 
     std::unique_ptr<Memory> mem = nullptr;
+    std::unique_ptr<BitmapMemory> bitmap = nullptr; // heap of mode bitmap
     std::string strategy = "first";
+    size_t unit = 16;
+    std::unique_ptr<IntervalSampler> sampler = nullptr;
     std::string line;
+    // the sampler's gauges read the heap of the kind it was opened on
+    auto switchingHeap = [&sampler]
+    {
+        if (!sampler)
+            return;
+        sampler.reset();
+        std::cout << "Interval sampling stopped.\n";
+    };
 
     while (true)
     {
@@ -46,7 +586,10 @@ void runAllocatorCLI()
         if (cmd == "back")
             break;
         if (cmd == "exit")
+        {
+            sampler.reset();
             exit(0);
+        }
 
         if (cmd == "init")
         {
@@ -56,44 +599,119 @@ void runAllocatorCLI()
                 std::cout << "Error: Usage 'init <size>'\n";
                 continue;
             }
+            if ((strategy == "bitmap") != (bitmap != nullptr))
+                switchingHeap();
+            mem.reset();
+            bitmap.reset();
+            if (strategy == "bitmap")
+            {
+                bitmap = std::make_unique<BitmapMemory>(size, unit);
+                bitmap->registerStats(stats::global());
+                std::cout << "Memory initialized: " << bitmap->total_memory() << " bytes (bitmap, " << unit << "-byte units).\n";
+                continue;
+            }
             mem = std::make_unique<Memory>(size);
+            mem->registerStats(stats::global());
             std::cout << "Memory initialized: " << size << " bytes.\n";
         }
         else if (cmd == "mode")
         {
             ss >> strategy;
             std::cout << "Strategy set to: " << strategy << "\n";
+            // the bitmap and the block list cannot share a heap: start an empty one
+            if (strategy == "bitmap" && mem)
+            {
+                switchingHeap();
+                bitmap = std::make_unique<BitmapMemory>(mem->total_memory(), unit);
+                bitmap->registerStats(stats::global());
+                mem.reset();
+                std::cout << "Heap re-initialized as a bitmap (" << bitmap->total_memory() << " bytes, " << unit << "-byte units).\n";
+            }
+            else if (strategy != "bitmap" && bitmap)
+            {
+                switchingHeap();
+                mem = std::make_unique<Memory>(bitmap->total_memory());
+                mem->registerStats(stats::global());
+                bitmap.reset();
+                std::cout << "Heap re-initialized as a block list (" << mem->total_memory() << " bytes).\n";
+            }
+        }
+        else if (cmd == "unit")
+        {
+            size_t bytes;
+            if (!(ss >> bytes) || !isPowerOfTwo(bytes))
+            {
+                std::cout << "Error: Usage 'unit <bytes>' (a power of 2)\n";
+                continue;
+            }
+            unit = bytes;
+            std::cout << "Bitmap unit set to " << unit << " bytes.\n";
+            if (bitmap)
+            {
+                bitmap = std::make_unique<BitmapMemory>(bitmap->total_memory(), unit);
+                bitmap->registerStats(stats::global());
+                std::cout << "Heap re-initialized as a bitmap (" << bitmap->total_memory() << " bytes, " << unit << "-byte units).\n";
+            }
+        }
+        else if (cmd == "bench")
+        {
+            uint64_t ops, seed = 1;
+            size_t maxSize;
+            if (!(mem || bitmap) || !(ss >> ops >> maxSize) || ops == 0 || maxSize == 0)
+            {
+                std::cout << "Usage: bench <ops> <maxSize> [seed] (after 'init')\n";
+                continue;
+            }
+            ss >> seed;
+            size_t size = mem ? mem->total_memory() : bitmap->total_memory();
+            bench_allocators(size, unit, ops, maxSize, seed);
         }
         else if (cmd == "malloc")
         {
-            if (!mem)
+            if (!mem && !bitmap)
             {
                 std::cout << "Error: Run 'init' first.\n";
                 continue;
             }
             size_t size;
             ss >> size;
-            int id = (strategy == "best") ? mem->allocate_bestfit(size) : (strategy == "worst") ? mem->allocate_worstfit(size)
+            int id = bitmap ? bitmap->allocate(size) : (strategy == "best") ? mem->allocate_bestfit(size) : (strategy == "worst") ? mem->allocate_worstfit(size)
                                                                                                 : mem->allocate_firstfit(size);
             if (id != -1)
                 std::cout << "Allocated block ID: " << id << "\n";
             else
                 std::cout << "Allocation failed (Fragmentation/OOM).\n";
+            if (sampler)
+                sampler->tick();
         }
         else if (cmd == "free")
         {
-            if (!mem)
+            if (!mem && !bitmap)
             {
                 std::cout << "Error: Run 'init' first.\n";
                 continue;
             }
             int id;
             ss >> id;
-            mem->free(id);
+            if (bitmap)
+                bitmap->free(id);
+            else
+                mem->free(id);
             std::cout << "Freed ID " << id << ".\n";
+            if (sampler)
+                sampler->tick();
         }
         else if (cmd == "stats")
         {
+            if (bitmap)
+            {
+                std::cout << "Total: " << bitmap->total_memory()
+                          << " | Used: " << bitmap->used_memory()
+                          << " | Success: " << bitmap->alloc_success_rate() << "%"
+                          << " | Ext Frag: " << bitmap->ext_frag() * 100 << "%"
+                          << " | Int Frag: " << bitmap->int_frag() * 100 << "%\n";
+                continue;
+            }
             if (!mem)
                 continue;
             std::cout << "Total: " << mem->total_memory()
@@ -105,6 +723,76 @@ void runAllocatorCLI()
         {
             if (mem)
                 mem->dump();
+            else if (bitmap)
+                bitmap->dump();
+        }
+        else if (cmd == "save")
+        {
+            std::string path;
+            if (bitmap)
+            {
+                std::cout << "Error: Checkpoints support the block-list allocator only.\n";
+                continue;
+            }
+            if (!mem || !(ss >> path))
+            {
+                std::cout << "Usage: save <file> (after 'init')\n";
+                continue;
+            }
+            CheckpointWriter out;
+            mem->save(out);
+            writeCheckpoint(out, path, CheckpointKind::Allocator);
+        }
+        else if (cmd == "load")
+        {
+            CheckpointReader in;
+            if (!openCheckpoint(ss, in, CheckpointKind::Allocator))
+                continue;
+            auto restored = Memory::restore(in);
+            if (!restored)
+            {
+                std::cout << "Error: " << in.error() << "\n";
+                continue;
+            }
+            if (bitmap)
+            {
+                switchingHeap();
+                bitmap.reset();
+            }
+            mem = std::move(restored);
+            mem->registerStats(stats::global());
+            if (strategy == "bitmap")
+            {
+                strategy = "first";
+                std::cout << "Strategy set to: first\n";
+            }
+            std::cout << "Memory restored: " << mem->total_memory() << " bytes.\n";
+        }
+        else if (cmd == "interval")
+        {
+            if (!mem && !bitmap)
+            {
+                std::cout << "Error: Run 'init' first.\n";
+                continue;
+            }
+            sampler.reset();
+            sampler = openSampler(ss);
+            if (sampler && bitmap)
+            {
+                sampler->addGauge("ext_frag", [&bitmap] { return bitmap->ext_frag(); });
+                sampler->addGauge("used_bytes", [&bitmap] { return (double)bitmap->used_memory(); });
+                sampler->addGauge("success_rate", [&bitmap] { return bitmap->alloc_success_rate(); });
+            }
+            else if (sampler)
+            {
+                sampler->addGauge("ext_frag", [&mem] { return mem->ext_frag(); });
+                sampler->addGauge("used_bytes", [&mem] { return (double)mem->used_memory(); });
+                sampler->addGauge("success_rate", [&mem] { return mem->alloc_success_rate(); });
+            }
+        }
+        else if (cmd == "export")
+        {
+            exportStats(ss);
         }
         else
         {
@@ -120,6 +808,7 @@ void runCacheCLI()
 
     std::unique_ptr<Cache> l1 = nullptr, l2 = nullptr;
     std::unique_ptr<cacheHierarchy> hierarchy = nullptr;
+    std::unique_ptr<IntervalSampler> sampler = nullptr;
     std::string line;
 
     while (true)
@@ -134,79 +823,1047 @@ void runCacheCLI()
         if (cmd == "back")
             break;
         if (cmd == "exit")
+        {
+            sampler.reset();
             exit(0);
+        }
 
         if (cmd == "init")
         {
-            size_t s1, s2, bs;
-            int as, pol;
-            if (!(ss >> s1 >> s2 >> bs >> as >> pol))
+            size_t s1, s2, bs;
+            int as, pol;
+            if (!(ss >> s1 >> s2 >> bs >> as >> pol))
+            {
+                std::cout << "Error: Invalid parameters.\n";
+                continue;
+            }
+            bool valid = true;
+            if (!isPowerOfTwo(s1) || !isPowerOfTwo(s2))
+            {
+                std::cout << "Error: Cache sizes must be powers of 2.\n";
+                valid = false;
+            }
+            if (!isPowerOfTwo(bs))
+            {
+                std::cout << "Error: Block size must be a power of 2.\n";
+                valid = false;
+            }
+            if (!isPowerOfTwo(as))
+            {
+                std::cout << "Error: Associativity must be a power of 2.\n";
+                valid = false;
+            }
+            // Check: Associativity <= (Cache Size / Block Size)
+            if (valid && (as > (s1 / bs) || as > (s2 / bs)))
+            {
+                std::cout << "Error: Associativity cannot exceed (CacheSize / BlockSize).\n";
+                valid = false;
+            }
+
+            if (!valid)
+                continue;
+
+            l1 = std::make_unique<Cache>(s1, bs, as, (bool)pol);
+            l2 = std::make_unique<Cache>(s2, bs, as, (bool)pol);
+            hierarchy = std::make_unique<cacheHierarchy>(l1.get(), l2.get());
+            hierarchy->registerStats(stats::global());
+            std::cout << "Hierarchy Ready (" << (pol ? "LRU" : "FIFO") << ").\n";
+        }
+        else if (cmd == "access")
+        {
+            if (!hierarchy)
+            {
+                std::cout << "Error: Run 'init' first.\n";
+                continue;
+            }
+            uint64_t addr;
+            int type;
+            if (!(ss >> addr >> type))
+                continue;
+            hierarchy->access(addr, (bool)type);
+            std::cout << (type ? "WRITE" : "READ") << " @ Address " << addr << "\n";
+            if (sampler)
+                sampler->tick();
+        }
+        else if (cmd == "gen")
+        {
+            if (!hierarchy)
+            {
+                std::cout << "Error: Run 'init' first.\n";
+                continue;
+            }
+            auto gen = openGenerator(ss);
+            if (!gen)
+                continue;
+            TraceRecord rec;
+            uint64_t count = 0;
+            while (gen->next(rec))
+            {
+                hierarchy->access(rec.addr, rec.write);
+                count++;
+                if (sampler)
+                    sampler->tick();
+            }
+            std::cout << "Generated " << count << " accesses.\n";
+        }
+        else if (cmd == "prefetch")
+        {
+            if (!hierarchy)
+            {
+                std::cout << "Error: Run 'init' first.\n";
+                continue;
+            }
+            configurePrefetch(ss, *hierarchy, *l1);
+        }
+        else if (cmd == "victim" || cmd == "mshr")
+        {
+            if (!hierarchy)
+            {
+                std::cout << "Error: Run 'init' first.\n";
+                continue;
+            }
+            configureMissBuffers(cmd, ss, *hierarchy);
+        }
+        else if (cmd == "save")
+        {
+            std::string path;
+            if (!hierarchy || !(ss >> path))
+            {
+                std::cout << "Usage: save <file> (after 'init')\n";
+                continue;
+            }
+            CheckpointWriter out;
+            l1->save(out);
+            l2->save(out);
+            writeCheckpoint(out, path, CheckpointKind::Cache);
+        }
+        else if (cmd == "load")
+        {
+            CheckpointReader in;
+            if (!openCheckpoint(ss, in, CheckpointKind::Cache))
+                continue;
+            auto r1 = Cache::restore(in);
+            auto r2 = r1 ? Cache::restore(in) : nullptr;
+            if (!r2)
+            {
+                std::cout << "Error: " << in.error() << "\n";
+                continue;
+            }
+            l1 = std::move(r1);
+            l2 = std::move(r2);
+            hierarchy = std::make_unique<cacheHierarchy>(l1.get(), l2.get());
+            hierarchy->registerStats(stats::global());
+            std::cout << "Hierarchy restored.\n";
+        }
+        else if (cmd == "interval")
+        {
+            if (!hierarchy)
+            {
+                std::cout << "Error: Run 'init' first.\n";
+                continue;
+            }
+            sampler.reset();
+            sampler = openSampler(ss);
+            if (sampler)
+                addCacheColumns(*sampler, l1, l2);
+        }
+        else if (cmd == "dump")
+        {
+            if (l1)
+            {
+                std::cout << "--- L1 Cache ---";
+                l1->dump();
+            }
+            if (l2)
+            {
+                std::cout << "--- L2 Cache ---";
+                l2->dump();
+            }
+        }
+        else if (cmd == "stats")
+        {
+            if (hierarchy)
+                hierarchy->stats();
+        }
+        else if (cmd == "mem")
+        {
+            printMemoryUsage(l1.get(), l2.get(), nullptr);
+        }
+        else if (cmd == "export")
+        {
+            exportStats(ss);
+        }
+        else
+        {
+            std::cout << "Unknown command.\n";
+        }
+    }
+}
+
+void runVirtualMemoryCLI()
+{
+    printHeader("Virtual Memory Simulator");
+    std::cout << "[Cmds: init <ram> <pg> <pol>, access <pid> <addr>, status, back]" << std::endl;
+
+    std::unique_ptr<PhysicalMemory> pm = nullptr;
+    std::unordered_map<int, std::unique_ptr<VirtualMemory>> processes;
+    std::unique_ptr<IntervalSampler> sampler = nullptr;
+    std::string line;
+
+    while (true)
+    {
+        std::cout << "vm> ";
+        if (!std::getline(std::cin, line))
+            break;
+        std::stringstream ss(line);
+        std::string cmd;
+        ss >> cmd;
+
+        if (cmd == "back")
+            break;
+        if (cmd == "exit")
+        {
+            // bare 'exit' quits; 'exit <pid>' ends one process
+            int pid;
+            if (!(ss >> pid))
+            {
+                sampler.reset();
+                exit(0);
+            }
+            exitProcess(pid, processes);
+            continue;
+        }
+
+        if (cmd == "init")
+        {
+            size_t rs, ps;
+            int pol;
+            if (!(ss >> rs >> ps >> pol))
+            {
+                std::cout << "Usage: init <ramSize> <pageSize> <0-4>\n";
+                continue;
+            }
+            if (pol < 0 || pol > 4)
+            {
+                std::cout << "Error: Policy must be 0 (FIFO), 1 (LRU), 2 (ARC), 3 (2Q) or 4 (LFU).\n";
+                continue;
+            }
+
+            if (!isPowerOfTwo(rs))
+            {
+                std::cout << "Error: RAM size (" << rs << ") must be a power of 2.\n";
+                continue;
+            }
+            if (!isPowerOfTwo(ps))
+            {
+                std::cout << "Error: Page size (" << ps << ") must be a power of 2.\n";
+                continue;
+            }
+            // Check: RAM Size > Page Size
+            if (rs <= ps)
+            {
+                std::cout << "Error: RAM size must be greater than Page size.\n";
+                continue;
+            }
+
+            pm = std::make_unique<PhysicalMemory>(rs, ps, (ReplacementKind)pol);
+            pm->registerStats(stats::global());
+            processes.clear();
+            std::cout << "Physical RAM ready (" << replacementName(pm->replacement()) << ").\n";
+        }
+        else if (cmd == "access")
+        {
+            if (!pm)
+                continue;
+            int pid, write = 0;
+            uint64_t vAddr;
+            if (!(ss >> pid >> vAddr))
+                continue;
+            ss >> write;
+            if (processes.find(pid) == processes.end())
+                processes[pid] = std::make_unique<VirtualMemory>(pm.get(), pid);
+            uint64_t pAddr = processes[pid]->translate(vAddr, write != 0);
+            std::cout << "PID " << pid << " | VA " << vAddr << " -> PA " << pAddr << "\n";
+            if (sampler)
+                sampler->tick();
+        }
+        else if (cmd == "gen")
+        {
+            if (!pm)
+            {
+                std::cout << "Error: Run 'init' first.\n";
+                continue;
+            }
+            auto gen = openGenerator(ss);
+            if (!gen)
+                continue;
+            TraceRecord rec;
+            uint64_t count = 0;
+            while (gen->next(rec))
+            {
+                if (processes.find(rec.pid) == processes.end())
+                    processes[rec.pid] = std::make_unique<VirtualMemory>(pm.get(), rec.pid);
+                processes[rec.pid]->translate(rec.addr, rec.write);
+                count++;
+                if (sampler)
+                    sampler->tick();
+            }
+            std::cout << "Generated " << count << " accesses.\n";
+        }
+        else if (cmd == "swap")
+        {
+            if (!pm)
+            {
+                std::cout << "Error: Run 'init' first.\n";
+                continue;
+            }
+            configureSwap(ss, *pm);
+        }
+        else if (cmd == "curve")
+        {
+            if (!pm)
+            {
+                std::cout << "Error: Run 'init' first.\n";
+                continue;
+            }
+            configureCurve(ss, *pm);
+        }
+        else if (cmd == "fork")
+        {
+            if (!pm)
+            {
+                std::cout << "Error: Run 'init' first.\n";
+                continue;
+            }
+            forkProcess(ss, processes);
+        }
+        else if (cmd == "tiers" || cmd == "placement" || cmd == "migrate")
+        {
+            if (!pm)
+            {
+                std::cout << "Error: Run 'init' first.\n";
+                continue;
+            }
+            configureTiers(cmd, ss, *pm);
+        }
+        else if (cmd == "status")
+        {
+            if (pm)
+                pm->printStatus();
+        }
+        else if (cmd == "mem")
+        {
+            printMemoryUsage(nullptr, nullptr, pm.get());
+        }
+        else if (cmd == "save")
+        {
+            std::string path;
+            if (!pm || !(ss >> path))
+            {
+                std::cout << "Usage: save <file> (after 'init')\n";
+                continue;
+            }
+            if (!canCheckpoint(*pm))
+                continue;
+            CheckpointWriter out;
+            pm->save(out);
+            saveProcesses(out, processes);
+            writeCheckpoint(out, path, CheckpointKind::VirtualMemory);
+        }
+        else if (cmd == "load")
+        {
+            CheckpointReader in;
+            if (!openCheckpoint(ss, in, CheckpointKind::VirtualMemory))
+                continue;
+            std::unordered_map<int, std::unique_ptr<VirtualMemory>> restoredProcs;
+            auto restored = PhysicalMemory::restore(in);
+            if (!restored || !restoreProcesses(in, restored.get(), restoredProcs))
+            {
+                std::cout << "Error: " << in.error() << "\n";
+                continue;
+            }
+            processes = std::move(restoredProcs);
+            pm = std::move(restored);
+            pm->registerStats(stats::global());
+            std::cout << "Physical RAM restored (" << processes.size() << " processes).\n";
+        }
+        else if (cmd == "interval")
+        {
+            if (!pm)
+            {
+                std::cout << "Error: Run 'init' first.\n";
+                continue;
+            }
+            sampler.reset();
+            sampler = openSampler(ss);
+            if (sampler)
+                addPagingColumns(*sampler, pm);
+        }
+        else if (cmd == "export")
+        {
+            exportStats(ss);
+        }
+        else
+        {
+            std::cout << "Unknown command.\n";
+        }
+    }
+}
+
+void runIntegratedCLI()
+{
+    printHeader("Integrated Mode (VM + Cache)");
+    std::cout << "[Cmds: init <ram> <pg> <l1> <l2> <blk> <asc>, access <pid> <addr> <0|1>, stats, dump, back]" << std::endl;
+
+    std::unique_ptr<PhysicalMemory> pm = nullptr;
+    std::unique_ptr<Cache> l1 = nullptr, l2 = nullptr;
+    std::unique_ptr<cacheHierarchy> hierarchy = nullptr;
+    std::unordered_map<int, std::unique_ptr<VirtualMemory>> processes;
+    SamplingConfig sampling;
+    std::unique_ptr<IntervalSampler> sampler = nullptr;
+    bool pipelined = false;
+    std::string line;
+
+    while (true)
+    {
+        std::cout << "integrated> ";
+        if (!std::getline(std::cin, line))
+            break;
+        std::stringstream ss(line);
+        std::string cmd;
+        ss >> cmd;
+
+        if (cmd == "back")
+            break;
+        if (cmd == "exit")
+        {
+            // bare 'exit' quits; 'exit <pid>' ends one process
+            int pid;
+            if (!(ss >> pid))
+            {
+                sampler.reset();
+                exit(0);
+            }
+            exitProcess(pid, processes);
+            continue;
+        }
+
+        if (cmd == "init")
+        {
+            size_t rs, ps, l1s, l2s, bs;
+            int as;
+            if (!(ss >> rs >> ps >> l1s >> l2s >> bs >> as))
+            {
+                std::cout << "Usage: init <ramS> <pageS> <L1S> <L2S> <blockS> <assoc>\n";
+                continue;
+            }
+            bool valid = true;
+
+            // Check Powers of Two
+            if (!isPowerOfTwo(rs))
+            {
+                std::cout << "Error: RAM size must be power of 2.\n";
+                valid = false;
+            }
+            if (!isPowerOfTwo(ps))
+            {
+                std::cout << "Error: Page size must be power of 2.\n";
+                valid = false;
+            }
+            if (!isPowerOfTwo(l1s))
+            {
+                std::cout << "Error: L1 size must be power of 2.\n";
+                valid = false;
+            }
+            if (!isPowerOfTwo(l2s))
+            {
+                std::cout << "Error: L2 size must be power of 2.\n";
+                valid = false;
+            }
+            if (!isPowerOfTwo(bs))
+            {
+                std::cout << "Error: Block size must be power of 2.\n";
+                valid = false;
+            }
+            if (!isPowerOfTwo(as))
+            {
+                std::cout << "Error: Associativity must be power of 2.\n";
+                valid = false;
+            }
+
+            // Functional Checks
+            if (valid && rs <= ps)
+            {
+                std::cout << "Error: RAM size must be greater than Page size.\n";
+                valid = false;
+            }
+            if (valid && (as > (l1s / bs) || as > (l2s / bs)))
+            {
+                std::cout << "Error: Associativity cannot exceed (CacheSize / BlockSize).\n";
+                valid = false;
+            }
+
+            if (!valid)
+                continue;
+
+            pm = std::make_unique<PhysicalMemory>(rs, ps, true);
+            l1 = std::make_unique<Cache>(l1s, bs, as, true);
+            l2 = std::make_unique<Cache>(l2s, bs, as, true);
+            hierarchy = std::make_unique<cacheHierarchy>(l1.get(), l2.get());
+            pm->registerStats(stats::global());
+            hierarchy->registerStats(stats::global());
+            processes.clear();
+            std::cout << "System ready (LRU Policy).\n";
+        }
+        else if (cmd == "access")
+        {
+            if (!pm || !hierarchy)
+                continue;
+            int pid;
+            uint64_t vAddr;
+            int write;
+            if (!(ss >> pid >> vAddr >> write))
+                continue;
+            if (processes.find(pid) == processes.end())
+                processes[pid] = std::make_unique<VirtualMemory>(pm.get(), pid);
+
+            uint64_t pAddr = processes[pid]->translate(vAddr, write);
+            hierarchy->access(pAddr, (bool)write);
+            std::cout << "Processed VA " << vAddr << " (" << (write ? "W" : "R") << ")\n";
+            if (sampler)
+                sampler->tick();
+        }
+        else if (cmd == "replay")
+        {
+            std::string path, error;
+            uint64_t first = 0;
+            if (!pm || !hierarchy || !(ss >> path))
+            {
+                std::cout << "Usage: replay <file> [first] (after 'init')\n";
+                continue;
+            }
+            ss >> first;
+            auto source = openTraceSource(path, error);
+            if (!source)
+            {
+                std::cout << "Error: " << error << "\n";
+                continue;
+            }
+            source->skip(first);
+            ReplayTarget target{pm.get(), l1.get(), l2.get(), hierarchy.get(), &processes};
+            if (sampling.enabled())
+                printSampled(replaySampled(*source, target, sampling), sampling);
+            else if (pipelined && !sampler)
+                std::cout << "Replayed " << replayPipelined(*source, target) << " accesses.\n";
+            else
+                std::cout << "Replayed " << replayTrace(*source, target, sampler.get()) << " accesses.\n";
+            if (!source->error().empty())
+                std::cout << "Error: " << source->error() << "\n";
+        }
+        else if (cmd == "gen")
+        {
+            if (!pm || !hierarchy)
+            {
+                std::cout << "Error: Run 'init' first.\n";
+                continue;
+            }
+            auto gen = openGenerator(ss);
+            if (!gen)
+                continue;
+            ReplayTarget target{pm.get(), l1.get(), l2.get(), hierarchy.get(), &processes};
+            if (sampling.enabled())
+                printSampled(replaySampled(*gen, target, sampling), sampling);
+            else if (pipelined && !sampler)
+                std::cout << "Generated " << replayPipelined(*gen, target) << " accesses.\n";
+            else
+                std::cout << "Generated " << replayTrace(*gen, target, sampler.get()) << " accesses.\n";
+        }
+        else if (cmd == "pipeline")
+        {
+            // pipeline on|off: decode, translate and cache stages on separate threads
+            std::string arg;
+            ss >> arg;
+            if (arg != "on" && arg != "off")
+            {
+                std::cout << "Usage: pipeline on|off\n";
+                continue;
+            }
+            pipelined = arg == "on";
+            if (!pipelined)
+                std::cout << "Pipeline disabled; replay runs on one thread.\n";
+            else if (sampler)
+                std::cout << "Pipeline enabled; replay stays sequential while interval sampling is on.\n";
+            else
+                std::cout << "Pipeline enabled; replay and gen run decode, translate and cache stages in parallel.\n";
+        }
+        else if (cmd == "opt")
+        {
+            // opt <file> | opt gen <kind> <count> ...: gap between this system and Belady OPT
+            std::string arg, error;
+            if (!pm || !hierarchy || !(ss >> arg))
+            {
+                std::cout << "Usage: opt <file> | opt gen <kind> <count> ... (after 'init')\n";
+                continue;
+            }
+            std::unique_ptr<TraceSource> source;
+            if (arg == "gen")
+                source = openGenerator(ss);
+            else if (!(source = openTraceSource(arg, error)))
+                std::cout << "Error: " << error << "\n";
+            if (!source)
+                continue;
+            SweepConfig config{pm->ramSize(), pm->pagesize, l1->getSize(), l2->getSize(),
+                               l1->getBlockSize(), l1->getAssociativity(), l1->usesLRU()};
+            printOptReport(compareWithOpt(config, *source), config);
+        }
+        else if (cmd == "sampling")
+        {
+            // sampling <period> <window> [warmup|all] | sampling off
+            std::string arg, warm;
+            ss >> arg;
+            if (arg == "off")
+            {
+                sampling = SamplingConfig();
+                std::cout << "Sampling disabled; replay simulates every access.\n";
+                continue;
+            }
+            SamplingConfig next;
+            std::stringstream num(arg);
+            if (!(num >> next.period) || !(ss >> next.window) || next.window == 0 || next.window > next.period)
+            {
+                std::cout << "Usage: sampling <period> <window> [warmup|all] | sampling off\n";
+                continue;
+            }
+            if (ss >> warm && warm != "all")
+            {
+                std::stringstream w(warm);
+                if (!(w >> next.warmup))
+                {
+                    std::cout << "Usage: sampling <period> <window> [warmup|all] | sampling off\n";
+                    continue;
+                }
+            }
+            sampling = next;
+            std::cout << "Sampling " << sampling.window << " of every " << sampling.period << " accesses.\n";
+        }
+        else if (cmd == "prefetch")
+        {
+            if (!hierarchy)
+            {
+                std::cout << "Error: Run 'init' first.\n";
+                continue;
+            }
+            configurePrefetch(ss, *hierarchy, *l1);
+        }
+        else if (cmd == "swap")
+        {
+            if (!pm)
+            {
+                std::cout << "Error: Run 'init' first.\n";
+                continue;
+            }
+            configureSwap(ss, *pm);
+        }
+        else if (cmd == "curve")
+        {
+            if (!pm)
+            {
+                std::cout << "Error: Run 'init' first.\n";
+                continue;
+            }
+            configureCurve(ss, *pm);
+        }
+        else if (cmd == "color")
+        {
+            if (!pm || !l2)
+            {
+                std::cout << "Error: Run 'init' first.\n";
+                continue;
+            }
+            configureColoring(ss, *pm, *l2);
+        }
+        else if (cmd == "fork")
+        {
+            if (!pm)
+            {
+                std::cout << "Error: Run 'init' first.\n";
+                continue;
+            }
+            forkProcess(ss, processes);
+        }
+        else if (cmd == "tiers" || cmd == "placement" || cmd == "migrate")
+        {
+            if (!pm)
+            {
+                std::cout << "Error: Run 'init' first.\n";
+                continue;
+            }
+            configureTiers(cmd, ss, *pm);
+        }
+        else if (cmd == "victim" || cmd == "mshr")
+        {
+            if (!hierarchy)
+            {
+                std::cout << "Error: Run 'init' first.\n";
+                continue;
+            }
+            configureMissBuffers(cmd, ss, *hierarchy);
+        }
+        else if (cmd == "save")
+        {
+            std::string path;
+            if (!pm || !hierarchy || !(ss >> path))
+            {
+                std::cout << "Usage: save <file> (after 'init')\n";
+                continue;
+            }
+            if (!canCheckpoint(*pm))
+                continue;
+            CheckpointWriter out;
+            pm->save(out);
+            l1->save(out);
+            l2->save(out);
+            saveProcesses(out, processes);
+            writeCheckpoint(out, path, CheckpointKind::Integrated);
+        }
+        else if (cmd == "load")
+        {
+            CheckpointReader in;
+            if (!openCheckpoint(ss, in, CheckpointKind::Integrated))
+                continue;
+            std::unordered_map<int, std::unique_ptr<VirtualMemory>> restoredProcs;
+            auto rpm = PhysicalMemory::restore(in);
+            auto r1 = rpm ? Cache::restore(in) : nullptr;
+            auto r2 = r1 ? Cache::restore(in) : nullptr;
+            if (!r2 || !restoreProcesses(in, rpm.get(), restoredProcs))
+            {
+                std::cout << "Error: " << in.error() << "\n";
+                continue;
+            }
+            processes = std::move(restoredProcs);
+            pm = std::move(rpm);
+            l1 = std::move(r1);
+            l2 = std::move(r2);
+            hierarchy = std::make_unique<cacheHierarchy>(l1.get(), l2.get());
+            pm->registerStats(stats::global());
+            hierarchy->registerStats(stats::global());
+            std::cout << "System restored (" << processes.size() << " processes).\n";
+        }
+        else if (cmd == "interval")
+        {
+            if (!pm || !hierarchy)
+            {
+                std::cout << "Error: Run 'init' first.\n";
+                continue;
+            }
+            sampler.reset();
+            sampler = openSampler(ss);
+            if (sampler)
+            {
+                addCacheColumns(*sampler, l1, l2);
+                addPagingColumns(*sampler, pm);
+            }
+        }
+        else if (cmd == "dump")
+        {
+            if (l1)
+            {
+                std::cout << "\n[L1 DUMP]\n";
+                l1->dump();
+            }
+            if (l2)
+            {
+                std::cout << "\n[L2 DUMP]\n";
+                l2->dump();
+            }
+            if (pm)
+            {
+                std::cout << "\n[PHYSICAL RAM DUMP]\n";
+                pm->printStatus();
+            }
+        }
+        else if (cmd == "stats")
+        {
+            if (hierarchy)
+                hierarchy->stats();
+        }
+        else if (cmd == "mem")
+        {
+            printMemoryUsage(l1.get(), l2.get(), pm.get());
+        }
+        else if (cmd == "export")
+        {
+            exportStats(ss);
+        }
+        else
+        {
+            std::cout << "Unknown command.\n";
+        }
+    }
+}
+
+// Every process heap starts here in its own virtual address space
+const uint64_t HEAP_BASE = 1ULL << 20;
+
+// One process in End-to-End mode: an allocator heap mapped into a page table
+struct HeapProcess
+{
+    std::unique_ptr<Memory> heap;
+    std::unique_ptr<VirtualMemory> vm;
+};
+
+void runEndToEndCLI()
+{
+    printHeader("End-to-End Mode (Allocator + VM + Cache)");
+    std::cout << "[Cmds: init <ram> <pg> <l1> <l2> <blk> <asc> <heap>, mode <first|best|worst>, malloc <pid> <size>, free <pid> <id>, load/store <pid> <id> <offset>, stats, dump, back]" << std::endl;
+
+    std::unique_ptr<PhysicalMemory> pm = nullptr;
+    std::unique_ptr<Cache> l1 = nullptr, l2 = nullptr;
+    std::unique_ptr<cacheHierarchy> hierarchy = nullptr;
+    std::map<int, HeapProcess> processes;
+    size_t heapSize = 0;
+    std::string strategy = "first";
+    std::unique_ptr<IntervalSampler> sampler = nullptr;
+    std::string line;
+
+    while (true)
+    {
+        std::cout << "e2e> ";
+        if (!std::getline(std::cin, line))
+            break;
+        std::stringstream ss(line);
+        std::string cmd;
+        ss >> cmd;
+
+        if (cmd == "back")
+            break;
+        if (cmd == "exit")
+        {
+            sampler.reset();
+            exit(0);
+        }
+
+        if (cmd == "init")
+        {
+            size_t rs, ps, l1s, l2s, bs, hs;
+            int as;
+            if (!(ss >> rs >> ps >> l1s >> l2s >> bs >> as >> hs))
+            {
+                std::cout << "Usage: init <ramS> <pageS> <L1S> <L2S> <blockS> <assoc> <heapS>\n";
+                continue;
+            }
+            if (!isPowerOfTwo(rs) || !isPowerOfTwo(ps) || !isPowerOfTwo(l1s) || !isPowerOfTwo(l2s) || !isPowerOfTwo(bs) || !isPowerOfTwo(as))
+            {
+                std::cout << "Error: RAM, page, cache and block sizes and associativity must be powers of 2.\n";
+                continue;
+            }
+            if (rs <= ps)
+            {
+                std::cout << "Error: RAM size must be greater than Page size.\n";
+                continue;
+            }
+            if ((size_t)as > (l1s / bs) || (size_t)as > (l2s / bs))
+            {
+                std::cout << "Error: Associativity cannot exceed (CacheSize / BlockSize).\n";
+                continue;
+            }
+            if (hs == 0)
+            {
+                std::cout << "Error: Heap size must be positive.\n";
+                continue;
+            }
+
+            pm = std::make_unique<PhysicalMemory>(rs, ps, true);
+            l1 = std::make_unique<Cache>(l1s, bs, as, true);
+            l2 = std::make_unique<Cache>(l2s, bs, as, true);
+            hierarchy = std::make_unique<cacheHierarchy>(l1.get(), l2.get());
+            // per-process heaps stay out of the registry: alloc.* is one set of metrics
+            pm->registerStats(stats::global());
+            hierarchy->registerStats(stats::global());
+            processes.clear();
+            heapSize = hs;
+            std::cout << "System ready (LRU Policy, " << hs << "-byte heap per process at VA " << HEAP_BASE << ").\n";
+        }
+        else if (cmd == "mode")
+        {
+            ss >> strategy;
+            std::cout << "Strategy set to: " << strategy << "\n";
+        }
+        else if (cmd == "malloc")
+        {
+            int pid;
+            size_t size;
+            if (!pm)
             {
-                std::cout << "Error: Invalid parameters.\n";
+                std::cout << "Error: Run 'init' first.\n";
                 continue;
             }
-            bool valid = true;
-            if (!isPowerOfTwo(s1) || !isPowerOfTwo(s2))
+            if (!(ss >> pid >> size) || size == 0)
             {
-                std::cout << "Error: Cache sizes must be powers of 2.\n";
-                valid = false;
+                std::cout << "Usage: malloc <pid> <size>\n";
+                continue;
             }
-            if (!isPowerOfTwo(bs))
+            HeapProcess &proc = processes[pid];
+            if (!proc.heap)
             {
-                std::cout << "Error: Block size must be a power of 2.\n";
-                valid = false;
+                proc.heap = std::make_unique<Memory>(heapSize);
+                proc.vm = std::make_unique<VirtualMemory>(pm.get(), pid);
             }
-            if (!isPowerOfTwo(as))
+            Memory &mem = *proc.heap;
+            int id = (strategy == "best") ? mem.allocate_bestfit(size) : (strategy == "worst") ? mem.allocate_worstfit(size)
+                                                                                               : mem.allocate_firstfit(size);
+            size_t addr, len;
+            if (id != -1 && mem.block_at(id, addr, len))
+                std::cout << "PID " << pid << " | Allocated block ID: " << id << " at VA " << HEAP_BASE + addr << "\n";
+            else
+                std::cout << "PID " << pid << " | Allocation failed (Fragmentation/OOM).\n";
+            if (sampler)
+                sampler->tick();
+        }
+        else if (cmd == "free")
+        {
+            int pid, id;
+            size_t addr, len;
+            if (!(ss >> pid >> id))
             {
-                std::cout << "Error: Associativity must be a power of 2.\n";
-                valid = false;
+                std::cout << "Usage: free <pid> <id>\n";
+                continue;
             }
-            // Check: Associativity <= (Cache Size / Block Size)
-            if (valid && (as > (s1 / bs) || as > (s2 / bs)))
+            auto it = processes.find(pid);
+            if (it == processes.end() || !it->second.heap->block_at(id, addr, len))
             {
-                std::cout << "Error: Associativity cannot exceed (CacheSize / BlockSize).\n";
-                valid = false;
+                std::cout << "Error: PID " << pid << " has no block " << id << ".\n";
+                continue;
             }
-
-            if (!valid)
+            it->second.heap->free(id);
+            std::cout << "PID " << pid << " | Freed ID " << id << ".\n";
+            if (sampler)
+                sampler->tick();
+        }
+        else if (cmd == "load" || cmd == "store")
+        {
+            int pid, id;
+            size_t offset, addr, len;
+            if (!(ss >> pid >> id >> offset))
+            {
+                std::cout << "Usage: " << cmd << " <pid> <id> <offset>\n";
                 continue;
-
-            l1 = std::make_unique<Cache>(s1, bs, as, (bool)pol);
-            l2 = std::make_unique<Cache>(s2, bs, as, (bool)pol);
-            hierarchy = std::make_unique<cacheHierarchy>(l1.get(), l2.get());
-            std::cout << "Hierarchy Ready (" << (pol ? "LRU" : "FIFO") << ").\n";
+            }
+            auto it = processes.find(pid);
+            if (it == processes.end() || !it->second.heap->block_at(id, addr, len))
+            {
+                std::cout << "Error: PID " << pid << " has no block " << id << ".\n";
+                continue;
+            }
+            if (offset >= len)
+            {
+                std::cout << "Error: Offset " << offset << " is outside block " << id << " (" << len << " bytes).\n";
+                continue;
+            }
+            bool write = (cmd == "store");
+            uint64_t vAddr = HEAP_BASE + addr + offset;
+            uint64_t pAddr = it->second.vm->translate(vAddr, write);
+            hierarchy->access(pAddr, write);
+            std::cout << "PID " << pid << " | " << (write ? "STORE" : "LOAD") << " block " << id << "+" << offset
+                      << " | VA " << vAddr << " -> PA " << pAddr << "\n";
+            if (sampler)
+                sampler->tick();
         }
-        else if (cmd == "access")
+        else if (cmd == "swap")
         {
-            if (!hierarchy)
+            if (!pm)
             {
                 std::cout << "Error: Run 'init' first.\n";
                 continue;
             }
-            uint64_t addr;
-            int type;
-            if (!(ss >> addr >> type))
+            configureSwap(ss, *pm);
+        }
+        else if (cmd == "curve")
+        {
+            if (!pm)
+            {
+                std::cout << "Error: Run 'init' first.\n";
                 continue;
-            hierarchy->access(addr, (bool)type);
-            std::cout << (type ? "WRITE" : "READ") << " @ Address " << addr << "\n";
+            }
+            configureCurve(ss, *pm);
         }
-        else if (cmd == "dump")
+        else if (cmd == "color")
         {
-            if (l1)
+            if (!pm || !l2)
             {
-                std::cout << "--- L1 Cache ---";
-                l1->dump();
+                std::cout << "Error: Run 'init' first.\n";
+                continue;
             }
-            if (l2)
+            configureColoring(ss, *pm, *l2);
+        }
+        else if (cmd == "tiers" || cmd == "placement" || cmd == "migrate")
+        {
+            if (!pm)
             {
-                std::cout << "--- L2 Cache ---";
-                l2->dump();
+                std::cout << "Error: Run 'init' first.\n";
+                continue;
+            }
+            configureTiers(cmd, ss, *pm);
+        }
+        else if (cmd == "interval")
+        {
+            if (!pm || !hierarchy)
+            {
+                std::cout << "Error: Run 'init' first.\n";
+                continue;
+            }
+            sampler.reset();
+            sampler = openSampler(ss);
+            if (sampler)
+            {
+                addCacheColumns(*sampler, l1, l2);
+                addPagingColumns(*sampler, pm);
             }
         }
+        else if (cmd == "mem")
+        {
+            printMemoryUsage(l1.get(), l2.get(), pm.get());
+        }
         else if (cmd == "stats")
         {
-            if (hierarchy)
-                hierarchy->stats();
+            if (!pm || !hierarchy)
+                continue;
+            std::cout << "\n========== End-to-End Stats ==========\n";
+            std::cout << std::fixed << std::setprecision(2);
+            std::cout << "Strategy: " << strategy << "\n";
+            for (const auto &p : processes)
+            {
+                const Memory &mem = *p.second.heap;
+                std::cout << "PID " << p.first << " Heap: Used " << mem.used_memory() << "/" << mem.total_memory()
+                          << " | Success: " << mem.alloc_success_rate() << "%"
+                          << " | Ext Frag: " << mem.ext_frag() * 100 << "%\n";
+            }
+            uint64_t translations = pm->pageFaults + pm->pageHits;
+            std::cout << "Page Faults: " << pm->pageFaults << " / " << translations << " translations";
+            if (translations)
+                std::cout << " (" << 100.0 * pm->pageFaults / translations << "%)";
+            std::cout << "\n";
+            if (const SwapDevice *swap = pm->swapDevice())
+                std::cout << "Major Faults: " << pm->majorFaults << " | Swap In/Out: " << swap->reads << "/" << swap->writes
+                          << " pages\n";
+            hierarchy->stats();
+        }
+        else if (cmd == "dump")
+        {
+            for (const auto &p : processes)
+            {
+                std::cout << "\n[PID " << p.first << " HEAP]\n";
+                p.second.heap->dump();
+            }
+            if (pm)
+            {
+                std::cout << "\n[PHYSICAL RAM DUMP]\n";
+                pm->printStatus();
+            }
+        }
+        else if (cmd == "export")
+        {
+            exportStats(ss);
         }
         else
         {
@@ -215,18 +1872,19 @@ void runCacheCLI()
     }
 }
 
-void runVirtualMemoryCLI()
+void runSweepCLI()
 {
-    printHeader("Virtual Memory Simulator");
-    std::cout << "[Cmds: init <ram> <pg> <pol>, access <pid> <addr>, status, back]" << std::endl;
+    printHeader("Sweep Mode (Parallel Design-Space Exploration)");
+    std::cout << "[Cmds: trace <file>, gen <kind> <count> ..., <ram|page|l1|l2|block|assoc|policy> <values...>, threads <n>, run, back]" << std::endl;
 
-    std::unique_ptr<PhysicalMemory> pm = nullptr;
-    std::unordered_map<int, std::unique_ptr<VirtualMemory>> processes;
+    SweepGrid grid;
+    std::vector<TraceRecord> trace;
+    unsigned threads = 0;
     std::string line;
 
     while (true)
     {
-        std::cout << "vm> ";
+        std::cout << "sweep> ";
         if (!std::getline(std::cin, line))
             break;
         std::stringstream ss(line);
@@ -238,54 +1896,74 @@ void runVirtualMemoryCLI()
         if (cmd == "exit")
             exit(0);
 
-        if (cmd == "init")
+        if (cmd == "trace" || cmd == "gen")
         {
-            size_t rs, ps;
-            int pol;
-            if (!(ss >> rs >> ps >> pol))
+            // read once into memory; every configuration replays the same records
+            std::unique_ptr<TraceSource> source;
+            if (cmd == "gen")
             {
-                std::cout << "Usage: init <ramSize> <pageSize> <0|1>\n";
-                continue;
+                source = openGenerator(ss);
             }
-
-            if (!isPowerOfTwo(rs))
+            else
             {
-                std::cout << "Error: RAM size (" << rs << ") must be a power of 2.\n";
-                continue;
+                std::string path, error;
+                if (!(ss >> path))
+                {
+                    std::cout << "Usage: trace <file>\n";
+                    continue;
+                }
+                source = openTraceSource(path, error);
+                if (!source)
+                    std::cout << "Error: " << error << "\n";
             }
-            if (!isPowerOfTwo(ps))
+            if (!source)
+                continue;
+            trace.clear();
+            TraceRecord rec;
+            while (source->next(rec))
+                trace.push_back(rec);
+            if (!source->error().empty())
+                std::cout << "Error: " << source->error() << "\n";
+            std::cout << "Loaded " << trace.size() << " accesses.\n";
+        }
+        else if (std::vector<uint64_t> *values = grid.param(cmd))
+        {
+            std::vector<uint64_t> parsed;
+            uint64_t v;
+            while (ss >> v)
+                parsed.push_back(v);
+            if (parsed.empty())
             {
-                std::cout << "Error: Page size (" << ps << ") must be a power of 2.\n";
+                std::cout << "Usage: " << cmd << " <value> [value ...]\n";
                 continue;
             }
-            // Check: RAM Size > Page Size
-            if (rs <= ps)
+            *values = parsed;
+            std::cout << "Sweeping " << cmd << " over " << parsed.size() << " value(s).\n";
+        }
+        else if (cmd == "threads")
+        {
+            if (!(ss >> threads))
             {
-                std::cout << "Error: RAM size must be greater than Page size.\n";
+                std::cout << "Usage: threads <n> (0 = all hardware threads)\n";
+                threads = 0;
                 continue;
             }
-
-            pm = std::make_unique<PhysicalMemory>(rs, ps, (bool)pol);
-            processes.clear();
-            std::cout << "Physical RAM ready (" << (pol ? "LRU" : "FIFO") << ").\n";
+            std::cout << "Threads set to: " << threads << "\n";
         }
-        else if (cmd == "access")
+        else if (cmd == "run")
         {
-            if (!pm)
-                continue;
-            int pid;
-            uint64_t vAddr;
-            if (!(ss >> pid >> vAddr))
+            if (trace.empty())
+            {
+                std::cout << "Error: Load a trace first ('trace' or 'gen').\n";
                 continue;
-            if (processes.find(pid) == processes.end())
-                processes[pid] = std::make_unique<VirtualMemory>(pm.get(), pid);
-            uint64_t pAddr = processes[pid]->translate(vAddr);
-            std::cout << "PID " << pid << " | VA " << vAddr << " -> PA " << pAddr << "\n";
+            }
+            std::vector<SweepConfig> configs = grid.expand();
+            std::cout << "Running " << configs.size() << " configurations over " << trace.size() << " accesses.\n";
+            printSweep(configs, runSweep(configs, trace, threads));
         }
-        else if (cmd == "status")
+        else if (cmd == "export")
         {
-            if (pm)
-                pm->printStatus();
+            exportStats(ss);
         }
         else
         {
@@ -294,20 +1972,17 @@ void runVirtualMemoryCLI()
     }
 }
 
-void runIntegratedCLI()
+void runMultiCoreCLI()
 {
-    printHeader("Integrated Mode (VM + Cache)");
-    std::cout << "[Cmds: init <ram> <pg> <l1> <l2> <blk> <asc>, access <pid> <addr> <0|1>, stats, dump, back]" << std::endl;
+    printHeader("Multi-core Mode (Private L1 + Shared L2, MESI)");
+    std::cout << "[Cmds: init <cores> <l1> <l2> <blk> <asc> <quantum>, access <core> <addr> <0|1>, trace <core> <file>, run, stats, back]" << std::endl;
 
-    std::unique_ptr<PhysicalMemory> pm = nullptr;
-    std::unique_ptr<Cache> l1 = nullptr, l2 = nullptr;
-    std::unique_ptr<cacheHierarchy> hierarchy = nullptr;
-    std::unordered_map<int, std::unique_ptr<VirtualMemory>> processes;
+    std::unique_ptr<MultiCoreSystem> system = nullptr;
     std::string line;
 
     while (true)
     {
-        std::cout << "integrated> ";
+        std::cout << "multicore> ";
         if (!std::getline(std::cin, line))
             break;
         std::stringstream ss(line);
@@ -321,107 +1996,119 @@ void runIntegratedCLI()
 
         if (cmd == "init")
         {
-            size_t rs, ps, l1s, l2s, bs;
-            int as;
-            if (!(ss >> rs >> ps >> l1s >> l2s >> bs >> as))
+            int cores, as;
+            size_t l1s, l2s, bs;
+            uint64_t quantum;
+            if (!(ss >> cores >> l1s >> l2s >> bs >> as >> quantum))
             {
-                std::cout << "Usage: init <ramS> <pageS> <L1S> <L2S> <blockS> <assoc>\n";
+                std::cout << "Usage: init <cores> <L1S> <L2S> <blockS> <assoc> <quantum>\n";
                 continue;
             }
             bool valid = true;
-
-            // Check Powers of Two
-            if (!isPowerOfTwo(rs))
-            {
-                std::cout << "Error: RAM size must be power of 2.\n";
-                valid = false;
-            }
-            if (!isPowerOfTwo(ps))
-            {
-                std::cout << "Error: Page size must be power of 2.\n";
-                valid = false;
-            }
-            if (!isPowerOfTwo(l1s))
+            if (cores < 1 || cores > 64)
             {
-                std::cout << "Error: L1 size must be power of 2.\n";
+                std::cout << "Error: Core count must be between 1 and 64.\n";
                 valid = false;
             }
-            if (!isPowerOfTwo(l2s))
+            if (!isPowerOfTwo(l1s) || !isPowerOfTwo(l2s))
             {
-                std::cout << "Error: L2 size must be power of 2.\n";
+                std::cout << "Error: Cache sizes must be powers of 2.\n";
                 valid = false;
             }
             if (!isPowerOfTwo(bs))
             {
-                std::cout << "Error: Block size must be power of 2.\n";
+                std::cout << "Error: Block size must be a power of 2.\n";
                 valid = false;
             }
             if (!isPowerOfTwo(as))
             {
-                std::cout << "Error: Associativity must be power of 2.\n";
+                std::cout << "Error: Associativity must be a power of 2.\n";
                 valid = false;
             }
-
-            // Functional Checks
-            if (valid && rs <= ps)
+            if (valid && ((size_t)as > (l1s / bs) || (size_t)as > (l2s / bs)))
             {
-                std::cout << "Error: RAM size must be greater than Page size.\n";
+                std::cout << "Error: Associativity cannot exceed (CacheSize / BlockSize).\n";
                 valid = false;
             }
-            if (valid && (as > (l1s / bs) || as > (l2s / bs)))
+            if (quantum == 0)
             {
-                std::cout << "Error: Associativity cannot exceed (CacheSize / BlockSize).\n";
+                std::cout << "Error: Quantum must be at least 1.\n";
                 valid = false;
             }
-
             if (!valid)
                 continue;
 
-            pm = std::make_unique<PhysicalMemory>(rs, ps, true);
-            l1 = std::make_unique<Cache>(l1s, bs, as, true);
-            l2 = std::make_unique<Cache>(l2s, bs, as, true);
-            hierarchy = std::make_unique<cacheHierarchy>(l1.get(), l2.get());
-            processes.clear();
-            std::cout << "System ready (LRU Policy).\n";
+            system = std::make_unique<MultiCoreSystem>(cores, l1s, l2s, bs, as, quantum);
+            std::cout << cores << "-core system ready (quantum " << quantum << " accesses).\n";
         }
         else if (cmd == "access")
         {
-            if (!pm || !hierarchy)
+            if (!system)
+            {
+                std::cout << "Error: Run 'init' first.\n";
                 continue;
-            int pid;
-            uint64_t vAddr;
-            int write;
-            if (!(ss >> pid >> vAddr >> write))
+            }
+            int core, write;
+            uint64_t addr;
+            if (!(ss >> core >> addr >> write))
                 continue;
-            if (processes.find(pid) == processes.end())
-                processes[pid] = std::make_unique<VirtualMemory>(pm.get(), pid);
-
-            uint64_t pAddr = processes[pid]->translate(vAddr);
-            hierarchy->access(pAddr, (bool)write);
-            std::cout << "Processed VA " << vAddr << " (" << (write ? "W" : "R") << ")\n";
+            if (core < 0 || core >= system->numCores())
+            {
+                std::cout << "Error: Invalid core " << core << ".\n";
+                continue;
+            }
+            system->addAccess(core, addr, (bool)write);
         }
-        else if (cmd == "dump")
+        else if (cmd == "trace")
         {
-            if (l1)
+            if (!system)
             {
-                std::cout << "\n[L1 DUMP]\n";
-                l1->dump();
+                std::cout << "Error: Run 'init' first.\n";
+                continue;
             }
-            if (l2)
+            int core;
+            std::string path;
+            if (!(ss >> core >> path) || core < 0 || core >= system->numCores())
             {
-                std::cout << "\n[L2 DUMP]\n";
-                l2->dump();
+                std::cout << "Usage: trace <core> <file>\n";
+                continue;
             }
-            if (pm)
+            std::ifstream in(path);
+            if (!in)
             {
-                std::cout << "\n[PHYSICAL RAM DUMP]\n";
-                pm->printStatus();
+                std::cout << "Error: Could not open " << path << "\n";
+                continue;
             }
+            // one "<addr> <0|1>" pair per line
+            uint64_t addr;
+            int write;
+            size_t count = 0;
+            while (in >> addr >> write)
+            {
+                system->addAccess(core, addr, (bool)write);
+                count++;
+            }
+            std::cout << "Queued " << count << " accesses on core " << core << ".\n";
+        }
+        else if (cmd == "run")
+        {
+            if (!system)
+            {
+                std::cout << "Error: Run 'init' first.\n";
+                continue;
+            }
+            size_t total = system->pending();
+            system->run();
+            std::cout << "Simulated " << total << " accesses.\n";
         }
         else if (cmd == "stats")
         {
-            if (hierarchy)
-                hierarchy->stats();
+            if (system)
+                system->stats();
+        }
+        else if (cmd == "export")
+        {
+            exportStats(ss);
         }
         else
         {
@@ -430,15 +2117,58 @@ void runIntegratedCLI()
     }
 }
 
+// memsim --convert <in.txt> <out.mtr>: re-encode a script or text trace
+int convertTrace(const std::string &inPath, const std::string &outPath)
+{
+    TextTraceSource in(inPath);
+    if (!in.isOpen())
+    {
+        std::cerr << "Could not open file: " << inPath << std::endl;
+        return 1;
+    }
+    BinaryTraceWriter out(outPath);
+    if (!out.isOpen())
+    {
+        std::cerr << "Could not write file: " << outPath << std::endl;
+        return 1;
+    }
+    TraceRecord rec;
+    while (in.next(rec))
+        out.add(rec);
+    if (!out.close())
+    {
+        std::cerr << "Could not write file: " << outPath << std::endl;
+        return 1;
+    }
+    std::cout << "Converted " << out.records() << " accesses to " << outPath << " (" << out.bytesWritten() << " bytes)\n";
+    return 0;
+}
+
 int main(int argc, char *argv[])
 {
-    // 1. File Redirection
-    if (argc > 1)
+    if (argc == 4 && std::string(argv[1]) == "--convert")
+        return convertTrace(argv[2], argv[3]);
+
+    // 1. Command line: [script] [--stats <file.json|file.csv>] | --convert <in> <out>
+    const char *script = nullptr;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--stats" && i + 1 < argc)
+            statsOutputPath = argv[++i];
+        else
+            script = argv[i];
+    }
+    if (!statsOutputPath.empty())
+        std::atexit(writeFinalStats);
+
+    // 2. File Redirection
+    if (script)
     {
-        static std::ifstream file(argv[1]);
+        static std::ifstream file(script);
         if (!file)
         {
-            std::cerr << "Could not open file: " << argv[1] << std::endl;
+            std::cerr << "Could not open file: " << script << std::endl;
             return 1;
         }
         std::cin.rdbuf(file.rdbuf());
@@ -447,7 +2177,7 @@ int main(int argc, char *argv[])
     while (true)
     {
         printHeader("Memory Management Simulator");
-        std::cout << "[1. Allocator | 2. Cache | 3. VM | 4. Integrated | 5. Exit]\nChoice: ";
+        std::cout << "[1. Allocator | 2. Cache | 3. VM | 4. Integrated | 5. Exit | 6. Multi-core | 7. End-to-End | 8. Sweep]\nChoice: ";
 
         int choice;
         if (!(std::cin >> choice))
@@ -478,6 +2208,15 @@ int main(int argc, char *argv[])
             break;
         case 5:
             return 0;
+        case 6:
+            runMultiCoreCLI();
+            break;
+        case 7:
+            runEndToEndCLI();
+            break;
+        case 8:
+            runSweepCLI();
+            break;
         default:
             std::cout << "Invalid.\n";
         }
@@ -0,0 +1,95 @@
+#include "missbuffers.h"
+
+VictimCache::VictimCache(size_t entries)
+    : numEntries(entries)
+{
+}
+
+size_t VictimCache::capacity() const
+{
+    return numEntries;
+}
+
+bool VictimCache::extract(uint64_t block)
+{
+    auto it = lruMap.find(block);
+    if (it == lruMap.end())
+    {
+        misses++;
+        return false;
+    }
+    hits++;
+    lruList.erase(it->second);
+    lruMap.erase(it);
+    return true;
+}
+
+void VictimCache::insert(uint64_t block)
+{
+    auto it = lruMap.find(block);
+    if (it != lruMap.end())
+    {
+        lruList.splice(lruList.begin(), lruList, it->second);
+        return;
+    }
+    if (numEntries == 0)
+        return;
+    if (lruList.size() == numEntries)
+    {
+        lruMap.erase(lruList.back());
+        lruList.pop_back();
+    }
+    lruList.push_front(block);
+    lruMap[block] = lruList.begin();
+}
+
+MSHRFile::MSHRFile(size_t entries, uint64_t latency_)
+    : numEntries(entries), latency(latency_)
+{
+}
+
+size_t MSHRFile::capacity() const
+{
+    return numEntries;
+}
+
+uint64_t MSHRFile::getLatency() const
+{
+    return latency;
+}
+
+void MSHRFile::retire(uint64_t now)
+{
+    while (!outstanding.empty() && outstanding.front().second <= now)
+    {
+        outstandingBlocks.erase(outstanding.front().first);
+        outstanding.pop_front();
+    }
+}
+
+bool MSHRFile::merge(uint64_t block, uint64_t now)
+{
+    retire(now);
+    if (!outstandingBlocks.count(block))
+        return false;
+    merged++;
+    return true;
+}
+
+void MSHRFile::allocate(uint64_t block, uint64_t now)
+{
+    retire(now);
+    if (outstanding.size() == numEntries)
+    {
+        // all registers busy: wait for the oldest miss to complete
+        stalls++;
+        stallCycles += outstanding.front().second - now;
+        outstandingBlocks.erase(outstanding.front().first);
+        outstanding.pop_front();
+    }
+    primary++;
+    outstanding.push_back({block, now + latency});
+    outstandingBlocks.insert(block);
+    if (outstanding.size() > peakOccupancy)
+        peakOccupancy = outstanding.size();
+}
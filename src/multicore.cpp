@@ -0,0 +1,270 @@
+#include "multicore.h"
+#include <thread>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+
+MultiCoreSystem::Barrier::Barrier(int parties_)
+    : parties(parties_)
+{
+}
+
+void MultiCoreSystem::Barrier::wait()
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    uint64_t gen = generation;
+    if (++waiting == parties)
+    {
+        waiting = 0;
+        generation++;
+        cv.notify_all();
+        return;
+    }
+    cv.wait(lock, [&] { return gen != generation; });
+}
+
+MultiCoreSystem::MultiCoreSystem(int numCores, size_t l1Size, size_t l2Size, size_t bSize, int assoc, uint64_t quantum_)
+    : cores(numCores), blockSize(bSize), quantum(quantum_ == 0 ? 1 : quantum_)
+{
+    for (auto &core : cores)
+        core.l1 = std::make_unique<Cache>(l1Size, blockSize, assoc, true);
+    l2 = std::make_unique<Cache>(l2Size, blockSize, assoc, true);
+}
+
+int MultiCoreSystem::numCores() const
+{
+    return (int)cores.size();
+}
+
+size_t MultiCoreSystem::pending() const
+{
+    size_t total = 0;
+    for (const auto &core : cores)
+        total += core.trace.size() - core.next;
+    return total;
+}
+
+void MultiCoreSystem::addAccess(int core, uint64_t physicalAddress, bool write)
+{
+    cores[core].trace.push_back({physicalAddress, write});
+}
+
+uint64_t MultiCoreSystem::blockOf(uint64_t addr) const
+{
+    return addr / blockSize;
+}
+
+void MultiCoreSystem::run()
+{
+    int n = (int)cores.size();
+    Barrier start(n + 1), finish(n + 1);
+    bool done = false;
+    std::vector<std::thread> workers;
+    for (int c = 0; c < n; c++)
+    {
+        workers.emplace_back([this, &start, &finish, &done, c] {
+            while (true)
+            {
+                start.wait();
+                if (done)
+                    return;
+                runQuantum(c);
+                finish.wait();
+            }
+        });
+    }
+    while (pending() > 0)
+    {
+        start.wait();
+        finish.wait();
+        applyQueued();
+        quantaRun++;
+    }
+    done = true;
+    start.wait();
+    for (auto &t : workers)
+        t.join();
+    for (auto &core : cores)
+    {
+        core.trace.clear();
+        core.next = 0;
+    }
+}
+
+void MultiCoreSystem::runQuantum(int c)
+{
+    // Only this core's L1 is touched here; the directory is read-only until
+    // the barrier, so workers never race with each other.
+    CoreState &core = cores[c];
+    size_t end = std::min(core.trace.size(), core.next + (size_t)quantum);
+    for (; core.next < end; core.next++)
+    {
+        const TraceEntry &e = core.trace[core.next];
+        core.accesses++;
+        if (!core.l1->contains(e.addr))
+        {
+            core.queued.push_back({e.write ? Request::Write : Request::Read, e.addr});
+            continue;
+        }
+        if (!e.write)
+        {
+            core.l1->access(e.addr, false);
+            continue;
+        }
+        // writes complete locally only in M; E -> M is settled at the barrier
+        auto it = directory.find(blockOf(e.addr));
+        if (it != directory.end() && it->second.owner == c && it->second.dirty)
+        {
+            core.l1->access(e.addr, true);
+            continue;
+        }
+        core.queued.push_back({Request::Write, e.addr});
+    }
+}
+
+void MultiCoreSystem::applyQueued()
+{
+    size_t longest = 0;
+    for (const auto &core : cores)
+        longest = std::max(longest, core.queued.size());
+    for (size_t i = 0; i < longest; i++)
+    {
+        for (int c = 0; c < (int)cores.size(); c++)
+        {
+            if (i >= cores[c].queued.size())
+                continue;
+            const QueuedRequest &req = cores[c].queued[i];
+            switch (req.type)
+            {
+            case Request::Read:
+                handleRead(c, req.addr);
+                break;
+            case Request::Write:
+                handleWrite(c, req.addr);
+                break;
+            }
+        }
+    }
+    for (auto &core : cores)
+        core.queued.clear();
+}
+
+void MultiCoreSystem::handleRead(int c, uint64_t addr)
+{
+    // an earlier request in this quantum may already have brought the line in
+    if (cores[c].l1->access(addr, false))
+        return;
+    recordEviction(c);
+    directoryLookups++;
+    DirEntry &d = directory[blockOf(addr)];
+    if (d.owner != -1 && d.owner != c)
+    {
+        // owner supplies the data and drops to S (writing back if dirty)
+        downgrades++;
+        peerTransfers++;
+        if (d.dirty)
+            writebacks++;
+        d.owner = -1;
+        d.dirty = false;
+    }
+    else
+    {
+        l2->access(addr, false);
+    }
+    bool alone = (d.sharers & ~(1ULL << c)) == 0;
+    d.sharers |= 1ULL << c;
+    if (alone)
+    {
+        d.owner = c; // E
+        d.dirty = false;
+    }
+}
+
+void MultiCoreSystem::handleWrite(int c, uint64_t addr)
+{
+    bool hit = cores[c].l1->access(addr, true);
+    if (!hit)
+        recordEviction(c);
+    claimExclusive(c, addr, hit);
+}
+
+void MultiCoreSystem::claimExclusive(int c, uint64_t addr, bool hadCopy)
+{
+    directoryLookups++;
+    DirEntry &d = directory[blockOf(addr)];
+    if (d.owner == c)
+    {
+        d.dirty = true; // E -> M, no traffic
+        return;
+    }
+    if (hadCopy)
+    {
+        upgradeRequests++;
+        cores[c].upgrades++;
+    }
+    bool peerSupplied = false;
+    for (int s = 0; s < (int)cores.size(); s++)
+    {
+        if (s == c || !(d.sharers & (1ULL << s)))
+            continue;
+        cores[s].l1->invalidate(addr);
+        invalidations++;
+        if (s == d.owner)
+            peerSupplied = true;
+    }
+    if (peerSupplied && !hadCopy)
+        peerTransfers++;
+    if (!hadCopy && !peerSupplied)
+        l2->access(addr, true);
+    d.sharers = 1ULL << c;
+    d.owner = c; // M
+    d.dirty = true;
+}
+
+void MultiCoreSystem::recordEviction(int c)
+{
+    uint64_t victim;
+    if (!cores[c].l1->lastEviction(victim))
+        return;
+    auto it = directory.find(blockOf(victim));
+    if (it == directory.end())
+        return;
+    DirEntry &d = it->second;
+    d.sharers &= ~(1ULL << c);
+    if (d.owner == c)
+    {
+        if (d.dirty)
+            writebacks++;
+        d.owner = -1;
+        d.dirty = false;
+    }
+    if (d.sharers == 0)
+        directory.erase(it);
+}
+
+void MultiCoreSystem::stats() const
+{
+    std::cout << "\n========== Multi-core Stats ==========\n";
+    std::cout << "Cores: " << cores.size() << " | Quantum: " << quantum << " | Quanta Run: " << quantaRun << "\n";
+    for (size_t c = 0; c < cores.size(); c++)
+    {
+        const CoreState &core = cores[c];
+        std::cout << "Core " << c << " L1: Accesses " << core.accesses
+                  << " | Hits " << core.l1->getHits()
+                  << " | Misses " << core.l1->getMisses()
+                  << " | Hit Rate " << std::fixed << std::setprecision(2) << core.l1->getHitRate() * 100 << "%"
+                  << " | Upgrades " << core.upgrades << "\n";
+    }
+    std::cout << "\nShared L2:\n";
+    std::cout << "  Hits:             " << l2->getHits() << "\n";
+    std::cout << "  Misses:           " << l2->getMisses() << "\n";
+    std::cout << "  Local Hit Rate:   " << l2->getHitRate() * 100 << "%\n";
+    std::cout << "\nCoherence Traffic (MESI):\n";
+    std::cout << "  Invalidations:    " << invalidations << "\n";
+    std::cout << "  Downgrades:       " << downgrades << " (E/M -> S)\n";
+    std::cout << "  Upgrades:         " << upgradeRequests << " (S -> M)\n";
+    std::cout << "  Cache-to-Cache:   " << peerTransfers << "\n";
+    std::cout << "  Writebacks:       " << writebacks << "\n";
+    std::cout << "  Directory Lookups: " << directoryLookups << "\n";
+    std::cout << "======================================\n";
+}
@@ -0,0 +1,252 @@
+#include "opt.h"
+#include "cache.h"
+#include "replay.h"
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <map>
+
+NextUseTable::NextUseTable(size_t chunkRecords_)
+    : chunkRecords(chunkRecords_ == 0 ? 1 : chunkRecords_)
+{
+}
+
+NextUseTable::~NextUseTable()
+{
+    if (keyFile)
+        std::fclose(keyFile);
+    if (nextFile)
+        std::fclose(nextFile);
+}
+
+uint64_t NextUseTable::size() const
+{
+    return total;
+}
+
+void NextUseTable::append(uint64_t key)
+{
+    keys.push_back(key);
+    total++;
+    if (keys.size() == chunkRecords && !spill())
+        failed = true;
+}
+
+bool NextUseTable::spill()
+{
+    if (!keyFile && !(keyFile = std::tmpfile()))
+        return false;
+    std::fseek(keyFile, 0, SEEK_END);
+    bool ok = std::fwrite(keys.data(), sizeof(uint64_t), keys.size(), keyFile) == keys.size();
+    keys.clear();
+    return ok;
+}
+
+bool NextUseTable::finalize()
+{
+    std::unordered_map<uint64_t, uint64_t> lastSeen;
+    if (failed)
+        return false;
+    if (!keyFile)
+    {
+        // whole stream fits in one chunk
+        nextUses.resize(keys.size());
+        for (size_t i = keys.size(); i-- > 0;)
+        {
+            auto it = lastSeen.find(keys[i]);
+            nextUses[i] = (it == lastSeen.end()) ? NEVER : it->second;
+            lastSeen[keys[i]] = i;
+        }
+        return true;
+    }
+
+    if (!keys.empty() && !spill())
+        return false;
+    if (!(nextFile = std::tmpfile()))
+        return false;
+    uint64_t chunks = (total + chunkRecords - 1) / chunkRecords;
+    for (uint64_t c = chunks; c-- > 0;)
+    {
+        uint64_t first = c * chunkRecords;
+        size_t count = (size_t)std::min<uint64_t>(chunkRecords, total - first);
+        keys.resize(count);
+        nextUses.resize(count);
+        std::fseek(keyFile, (long)(first * sizeof(uint64_t)), SEEK_SET);
+        if (std::fread(keys.data(), sizeof(uint64_t), count, keyFile) != count)
+            return false;
+        for (size_t i = count; i-- > 0;)
+        {
+            auto it = lastSeen.find(keys[i]);
+            nextUses[i] = (it == lastSeen.end()) ? NEVER : it->second;
+            lastSeen[keys[i]] = first + i;
+        }
+        std::fseek(nextFile, (long)(first * sizeof(uint64_t)), SEEK_SET);
+        if (std::fwrite(nextUses.data(), sizeof(uint64_t), count, nextFile) != count)
+            return false;
+    }
+    keys.clear();
+    nextUses.clear();
+    return std::fflush(nextFile) == 0;
+}
+
+bool NextUseTable::loadChunk(uint64_t chunk)
+{
+    uint64_t first = chunk * chunkRecords;
+    size_t count = (size_t)std::min<uint64_t>(chunkRecords, total - first);
+    keys.resize(count);
+    nextUses.resize(count);
+    std::fseek(keyFile, (long)(first * sizeof(uint64_t)), SEEK_SET);
+    std::fseek(nextFile, (long)(first * sizeof(uint64_t)), SEEK_SET);
+    return std::fread(keys.data(), sizeof(uint64_t), count, keyFile) == count &&
+           std::fread(nextUses.data(), sizeof(uint64_t), count, nextFile) == count;
+}
+
+bool NextUseTable::next(uint64_t &key, uint64_t &nextUse)
+{
+    if (readPos >= total)
+        return false;
+    if (keyFile && readPos % chunkRecords == 0)
+    {
+        if (!loadChunk(readPos / chunkRecords))
+        {
+            failed = true;
+            return false;
+        }
+        bufferPos = 0;
+    }
+    key = keys[bufferPos];
+    nextUse = nextUses[bufferPos];
+    bufferPos++;
+    readPos++;
+    return true;
+}
+
+OptCache::OptCache(size_t numSets, size_t ways_)
+    : sets(numSets == 0 ? 1 : numSets), ways(ways_ == 0 ? 1 : ways_)
+{
+}
+
+void OptCache::compact(Set &set)
+{
+    set.heap.clear();
+    for (const auto &r : set.resident)
+        set.heap.push_back({r.second, r.first});
+    std::make_heap(set.heap.begin(), set.heap.end());
+}
+
+bool OptCache::access(uint64_t key, uint64_t nextUse)
+{
+    Set &set = sets[key % sets.size()];
+    auto it = set.resident.find(key);
+    bool hit = it != set.resident.end();
+    if (hit)
+    {
+        hits++;
+        it->second = nextUse;
+    }
+    else
+    {
+        misses++;
+        if (set.resident.size() == ways)
+        {
+            // discard stale entries until the top is a live (next use, key) pair
+            while (true)
+            {
+                std::pop_heap(set.heap.begin(), set.heap.end());
+                auto top = set.heap.back();
+                set.heap.pop_back();
+                auto victim = set.resident.find(top.second);
+                if (victim != set.resident.end() && victim->second == top.first)
+                {
+                    set.resident.erase(victim);
+                    break;
+                }
+            }
+        }
+        set.resident[key] = nextUse;
+    }
+    set.heap.push_back({nextUse, key});
+    std::push_heap(set.heap.begin(), set.heap.end());
+    if (set.heap.size() > 4 * ways + 64)
+        compact(set);
+    return hit;
+}
+
+namespace
+{
+    // Runs OPT over a finalized stream; misses are optionally forwarded
+    bool runOpt(NextUseTable &table, OptCache &cache, NextUseTable *missStream)
+    {
+        uint64_t key, nextUse;
+        while (table.next(key, nextUse))
+        {
+            if (!cache.access(key, nextUse) && missStream)
+                missStream->append(key);
+        }
+        return table.size() == cache.hits + cache.misses;
+    }
+}
+
+OptReport compareWithOpt(const SweepConfig &config, TraceSource &source, size_t chunkRecords)
+{
+    OptReport report;
+    PhysicalMemory pm(config.ram, config.page, config.lru);
+    Cache l1(config.l1, config.block, config.assoc, config.lru);
+    Cache l2(config.l2, config.block, config.assoc, config.lru);
+    cacheHierarchy hierarchy(&l1, &l2);
+    ProcessMap processes;
+    ReplayTarget target{&pm, &l1, &l2, &hierarchy, &processes};
+
+    // pages are renumbered densely so (pid, vpn) fits one key
+    std::map<std::pair<int, uint64_t>, uint64_t> pageIds;
+    NextUseTable pages(chunkRecords), blocks(chunkRecords), l1Misses(chunkRecords);
+    TraceRecord rec;
+    while (source.next(rec))
+    {
+        auto id = pageIds.emplace(std::make_pair(rec.pid, rec.addr / config.page), pageIds.size()).first->second;
+        pages.append(id);
+        uint64_t pAddr = processFor(target, rec.pid).translate(rec.addr, rec.write);
+        hierarchy.access(pAddr, rec.write);
+        blocks.append(pAddr / config.block);
+        report.accesses++;
+    }
+    report.l1Misses = l1.getMisses();
+    report.l2Misses = l2.getMisses();
+    report.faults = pm.pageFaults;
+
+    OptCache frameOpt(1, config.ram / config.page);
+    OptCache l1Opt(config.l1 / (config.block * config.assoc), config.assoc);
+    OptCache l2Opt(config.l2 / (config.block * config.assoc), config.assoc);
+    report.ok = pages.finalize() && runOpt(pages, frameOpt, nullptr) &&
+                blocks.finalize() && runOpt(blocks, l1Opt, &l1Misses) &&
+                l1Misses.finalize() && runOpt(l1Misses, l2Opt, nullptr);
+    report.optFaults = frameOpt.misses;
+    report.l1OptMisses = l1Opt.misses;
+    report.l2OptMisses = l2Opt.misses;
+    return report;
+}
+
+void printOptReport(const OptReport &r, const SweepConfig &config)
+{
+    if (!r.ok)
+    {
+        std::cout << "Error: Could not use temporary files for the OPT pass.\n";
+        return;
+    }
+    auto row = [](const char *name, uint64_t actual, uint64_t opt) {
+        std::cout << name << std::setw(10) << actual << std::setw(10) << opt;
+        if (opt)
+            std::cout << std::setw(9) << 100.0 * ((double)actual - (double)opt) / opt << "%";
+        std::cout << "\n";
+    };
+    const char *policy = config.lru ? "LRU" : "FIFO";
+    std::cout << "\n========== OPT Comparison ==========\n";
+    std::cout << "Accesses: " << r.accesses << "\n";
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "              " << std::setw(10) << policy << std::setw(10) << "OPT" << std::setw(10) << "Excess" << "\n";
+    row("Page Faults:  ", r.faults, r.optFaults);
+    row("L1 Misses:    ", r.l1Misses, r.l1OptMisses);
+    row("L2 Misses:    ", r.l2Misses, r.l2OptMisses);
+    std::cout << "(L2 OPT sees the L1 OPT miss stream; Excess = extra misses over OPT)\n";
+    std::cout << "====================================\n";
+}
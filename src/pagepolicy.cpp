@@ -0,0 +1,273 @@
+#include "pagepolicy.h"
+#include <algorithm>
+
+const char *replacementName(ReplacementKind kind)
+{
+    switch (kind)
+    {
+    case ReplacementKind::FIFO:
+        return "FIFO";
+    case ReplacementKind::LRU:
+        return "LRU";
+    case ReplacementKind::ARC:
+        return "ARC";
+    case ReplacementKind::TwoQ:
+        return "2Q";
+    case ReplacementKind::LFU:
+        return "LFU";
+    }
+    return "?";
+}
+
+PagePolicy::PagePolicy(size_t frames_)
+    : frames(frames_)
+{
+}
+
+std::unique_ptr<PagePolicy> makePagePolicy(ReplacementKind kind, size_t frames)
+{
+    switch (kind)
+    {
+    case ReplacementKind::ARC:
+        return std::make_unique<ArcPolicy>(frames);
+    case ReplacementKind::TwoQ:
+        return std::make_unique<TwoQPolicy>(frames);
+    case ReplacementKind::LFU:
+        return std::make_unique<LfuPolicy>(frames);
+    default:
+        return nullptr;
+    }
+}
+
+// ---------------------------------------------------------------- ARC
+
+ArcPolicy::ArcPolicy(size_t frames)
+    : PagePolicy(frames), resident(frames)
+{
+}
+
+void ArcPolicy::dropGhost(std::list<PageId> &list)
+{
+    if (list.empty())
+        return;
+    ghosts.erase(list.back());
+    list.pop_back();
+}
+
+void ArcPolicy::addGhost(const PageId &page, bool toB2)
+{
+    std::list<PageId> &list = toB2 ? b2 : b1;
+    list.push_front(page);
+    ghosts[page] = Ghost{toB2, list.begin()};
+}
+
+bool ArcPolicy::admit(const PageId &page)
+{
+    auto g = ghosts.find(page);
+    if (g == ghosts.end())
+        return false;
+    // a ghost hit says the list it was evicted from was too small
+    if (!g->second.inB2)
+        p = std::min(frames, p + std::max<size_t>(1, b2.size() / b1.size()));
+    else
+        p -= std::min(p, std::max<size_t>(1, b1.size() / b2.size()));
+    (g->second.inB2 ? b2 : b1).erase(g->second.pos);
+    ghosts.erase(g);
+    return true;
+}
+
+FrameNumber ArcPolicy::replace(bool ghostInB2)
+{
+    bool fromT1 = !t1.empty() && (t2.empty() || t1.size() > p || (ghostInB2 && t1.size() == p));
+    std::list<FrameNumber> &list = fromT1 ? t1 : t2;
+    FrameNumber frame = list.back();
+    list.pop_back();
+    addGhost(resident[frame].page, !fromT1);
+    return frame;
+}
+
+FrameNumber ArcPolicy::victim(const PageId &incoming)
+{
+    auto g = ghosts.find(incoming);
+    bool ghostInB2 = g != ghosts.end() && g->second.inB2;
+    decided = true;
+    fillT2 = admit(incoming);
+    if (fillT2)
+        return replace(ghostInB2);
+
+    if (t1.size() + b1.size() >= frames)
+    {
+        if (t1.size() < frames)
+        {
+            dropGhost(b1);
+            return replace(false);
+        }
+        // T1 holds every frame: evict its LRU page without remembering it
+        FrameNumber frame = t1.back();
+        t1.pop_back();
+        return frame;
+    }
+    if (t1.size() + t2.size() + b1.size() + b2.size() >= 2 * frames)
+        dropGhost(b2);
+    return replace(false);
+}
+
+void ArcPolicy::fill(FrameNumber frame, const PageId &page)
+{
+    if (!decided)
+    {
+        // free frame: only the ghost directory needs attention
+        fillT2 = admit(page);
+        if (!fillT2 && t1.size() + b1.size() >= frames)
+            dropGhost(b1);
+        else if (!fillT2 && t1.size() + t2.size() + b1.size() + b2.size() >= 2 * frames)
+            dropGhost(b2);
+    }
+    decided = false;
+    std::list<FrameNumber> &list = fillT2 ? t2 : t1;
+    list.push_front(frame);
+    resident[frame] = Resident{page, fillT2, list.begin()};
+}
+
+void ArcPolicy::relocate(FrameNumber from, FrameNumber to, bool exchange)
+{
+    relocateRecord(resident, from, to, exchange);
+}
+
+void ArcPolicy::remove(FrameNumber frame)
+{
+    Resident &r = resident[frame];
+    (r.inT2 ? t2 : t1).erase(r.pos);
+}
+
+void ArcPolicy::touch(FrameNumber frame)
+{
+    Resident &r = resident[frame];
+    t2.splice(t2.begin(), r.inT2 ? t2 : t1, r.pos);
+    r.inT2 = true;
+}
+
+// ---------------------------------------------------------------- 2Q
+
+TwoQPolicy::TwoQPolicy(size_t frames)
+    : PagePolicy(frames), resident(frames),
+      kin(std::max<size_t>(1, frames / 4)), kout(std::max<size_t>(1, frames / 2))
+{
+}
+
+FrameNumber TwoQPolicy::victim(const PageId &)
+{
+    FrameNumber frame;
+    if (!a1in.empty() && (a1in.size() > kin || am.empty()))
+    {
+        frame = a1in.back();
+        a1in.pop_back();
+        a1out.push_front(resident[frame].page);
+        a1outMap[resident[frame].page] = a1out.begin();
+        if (a1out.size() > kout)
+        {
+            a1outMap.erase(a1out.back());
+            a1out.pop_back();
+        }
+    }
+    else
+    {
+        frame = am.back();
+        am.pop_back();
+    }
+    return frame;
+}
+
+void TwoQPolicy::fill(FrameNumber frame, const PageId &page)
+{
+    auto it = a1outMap.find(page);
+    bool reuse = it != a1outMap.end();
+    if (reuse)
+    {
+        a1out.erase(it->second);
+        a1outMap.erase(it);
+    }
+    std::list<FrameNumber> &list = reuse ? am : a1in;
+    list.push_front(frame);
+    resident[frame] = Resident{page, reuse, list.begin()};
+}
+
+void TwoQPolicy::relocate(FrameNumber from, FrameNumber to, bool exchange)
+{
+    relocateRecord(resident, from, to, exchange);
+}
+
+void TwoQPolicy::remove(FrameNumber frame)
+{
+    Resident &r = resident[frame];
+    (r.inAm ? am : a1in).erase(r.pos);
+}
+
+void TwoQPolicy::touch(FrameNumber frame)
+{
+    // hits inside A1in are deliberately ignored: a scan touches a page in bursts
+    if (resident[frame].inAm)
+        am.splice(am.begin(), am, resident[frame].pos);
+}
+
+// ---------------------------------------------------------------- LFU
+
+LfuPolicy::LfuPolicy(size_t frames)
+    : PagePolicy(frames), resident(frames)
+{
+}
+
+void LfuPolicy::place(FrameNumber frame, std::list<Bucket>::iterator bucket)
+{
+    bucket->frames.push_front(frame);
+    resident[frame] = Resident{bucket, bucket->frames.begin()};
+}
+
+void LfuPolicy::unlink(FrameNumber frame)
+{
+    Resident &r = resident[frame];
+    r.bucket->frames.erase(r.pos);
+    if (r.bucket->frames.empty())
+        buckets.erase(r.bucket);
+}
+
+void LfuPolicy::fill(FrameNumber frame, const PageId &)
+{
+    // every resident key is >= age, so at most one bucket precedes age + 1
+    uint64_t key = age + 1;
+    auto it = buckets.begin();
+    while (it != buckets.end() && it->key < key)
+        ++it;
+    if (it == buckets.end() || it->key != key)
+        it = buckets.insert(it, Bucket{key, {}});
+    place(frame, it);
+}
+
+void LfuPolicy::touch(FrameNumber frame)
+{
+    auto bucket = resident[frame].bucket;
+    auto next = std::next(bucket);
+    if (next == buckets.end() || next->key != bucket->key + 1)
+        next = buckets.insert(next, Bucket{bucket->key + 1, {}});
+    unlink(frame);
+    place(frame, next);
+}
+
+void LfuPolicy::relocate(FrameNumber from, FrameNumber to, bool exchange)
+{
+    relocateRecord(resident, from, to, exchange);
+}
+
+void LfuPolicy::remove(FrameNumber frame)
+{
+    unlink(frame);
+}
+
+FrameNumber LfuPolicy::victim(const PageId &)
+{
+    auto lowest = buckets.begin();
+    FrameNumber frame = lowest->frames.back();
+    age = lowest->key;
+    unlink(frame);
+    return frame;
+}
@@ -0,0 +1,131 @@
+#include "prefetcher.h"
+
+Prefetcher::Prefetcher(size_t bSize, int degree_)
+    : blockSize(bSize), degree(degree_ < 1 ? 1 : degree_)
+{
+}
+
+std::unique_ptr<Prefetcher> makePrefetcher(const std::string &kind, size_t blockSize, int degree)
+{
+    if (kind == "next")
+        return std::make_unique<NextLinePrefetcher>(blockSize, degree);
+    if (kind == "stride")
+        return std::make_unique<StreamPrefetcher>(blockSize, degree);
+    if (kind == "corr")
+        return std::make_unique<CorrelationPrefetcher>(blockSize, degree);
+    return nullptr;
+}
+
+void NextLinePrefetcher::observe(uint64_t blockAddr, bool hit, bool prefetchHit, std::vector<uint64_t> &out)
+{
+    if (hit && !prefetchHit)
+        return;
+    for (int k = 1; k <= degree; k++)
+        out.push_back(blockAddr + k * blockSize);
+}
+
+StreamPrefetcher::StreamPrefetcher(size_t bSize, int degree_)
+    : Prefetcher(bSize, degree_), streams(NUM_STREAMS)
+{
+}
+
+void StreamPrefetcher::observe(uint64_t blockAddr, bool hit, bool prefetchHit, std::vector<uint64_t> &out)
+{
+    // train on the miss stream plus hits that a prefetch made possible
+    if (hit && !prefetchHit)
+        return;
+    clock++;
+    int64_t block = blockAddr / blockSize;
+    Stream *match = nullptr;
+    Stream *oldest = &streams[0];
+    for (auto &s : streams)
+    {
+        if (s.valid)
+        {
+            int64_t distance = block - (int64_t)s.lastBlock;
+            if (distance != 0 && distance >= -WINDOW && distance <= WINDOW)
+            {
+                match = &s;
+                break;
+            }
+        }
+        if (!s.valid || s.lastUse < oldest->lastUse)
+            oldest = &s;
+    }
+
+    if (!match)
+    {
+        *oldest = Stream();
+        oldest->valid = true;
+        oldest->lastBlock = block;
+        oldest->lastUse = clock;
+        return;
+    }
+
+    int64_t stride = block - (int64_t)match->lastBlock;
+    if (stride == match->stride)
+    {
+        match->confidence++;
+    }
+    else
+    {
+        match->stride = stride;
+        match->confidence = 1;
+    }
+    match->lastBlock = block;
+    match->lastUse = clock;
+    if (match->confidence < 2)
+        return;
+    for (int k = 1; k <= degree; k++)
+    {
+        int64_t target = block + stride * k;
+        if (target < 0)
+            break;
+        out.push_back((uint64_t)target * blockSize);
+    }
+}
+
+CorrelationPrefetcher::CorrelationPrefetcher(size_t bSize, int degree_)
+    : Prefetcher(bSize, degree_), table(TABLE_SIZE)
+{
+}
+
+CorrelationPrefetcher::Entry &CorrelationPrefetcher::slot(uint64_t block)
+{
+    // multiplicative hash keeps strided miss blocks from piling into one slot
+    return table[(block * 0x9E3779B97F4A7C15ULL) >> 52];
+}
+
+void CorrelationPrefetcher::observe(uint64_t blockAddr, bool hit, bool prefetchHit, std::vector<uint64_t> &out)
+{
+    if (hit && !prefetchHit)
+        return;
+    uint64_t block = blockAddr / blockSize;
+
+    // record block as the newest successor of the previous miss
+    if (haveLast)
+    {
+        Entry &prev = slot(lastBlock);
+        if (!prev.valid || prev.block != lastBlock)
+        {
+            prev = Entry();
+            prev.valid = true;
+            prev.block = lastBlock;
+        }
+        if (prev.count == 0 || prev.next[0] != block)
+        {
+            prev.next[1] = prev.next[0];
+            prev.next[0] = block;
+            if (prev.count < 2)
+                prev.count++;
+        }
+    }
+    haveLast = true;
+    lastBlock = block;
+
+    const Entry &e = slot(block);
+    if (!e.valid || e.block != block)
+        return;
+    for (int k = 0; k < e.count && k < degree; k++)
+        out.push_back(e.next[k] * blockSize);
+}
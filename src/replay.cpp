@@ -0,0 +1,246 @@
+#include "replay.h"
+#include "ringbuffer.h"
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <thread>
+
+VirtualMemory &processFor(const ReplayTarget &target, int pid)
+{
+    auto &slot = (*target.processes)[pid];
+    if (!slot)
+        slot = std::make_unique<VirtualMemory>(target.pm, pid);
+    return *slot;
+}
+
+namespace
+{
+    // Accesses per block handed to the batch APIs and between pipeline stages
+    const size_t REPLAY_BATCH = 256;
+    const size_t PIPELINE_DEPTH = 16 * REPLAY_BATCH;
+
+    struct PhysicalAccess
+    {
+        uint64_t addr;
+        bool write;
+    };
+
+    // Fills up to REPLAY_BATCH records; returns how many
+    size_t readBlock(TraceSource &source, TraceRecord *recs)
+    {
+        size_t n = 0;
+        while (n < REPLAY_BATCH && source.next(recs[n]))
+            n++;
+        return n;
+    }
+
+    // Translates a block in order, one batch per run of records from the
+    // same process
+    void translateBlock(const ReplayTarget &target, const TraceRecord *recs, size_t n,
+                        uint64_t *physicalAddrs, bool *writes)
+    {
+        uint64_t virtualAddrs[REPLAY_BATCH];
+        for (size_t i = 0; i < n; i++)
+        {
+            virtualAddrs[i] = recs[i].addr;
+            writes[i] = recs[i].write;
+        }
+        for (size_t first = 0; first < n;)
+        {
+            size_t last = first + 1;
+            while (last < n && recs[last].pid == recs[first].pid)
+                last++;
+            processFor(target, recs[first].pid).translateBatch(virtualAddrs + first, writes + first, last - first,
+                                                               physicalAddrs + first);
+            first = last;
+        }
+    }
+}
+
+uint64_t replayTrace(TraceSource &source, const ReplayTarget &target, IntervalSampler *sampler)
+{
+    uint64_t count = 0;
+    if (sampler)
+    {
+        // the sampler reads counters after every access
+        TraceRecord rec;
+        while (source.next(rec))
+        {
+            uint64_t pAddr = processFor(target, rec.pid).translate(rec.addr, rec.write);
+            target.hierarchy->access(pAddr, rec.write);
+            count++;
+            sampler->tick();
+        }
+        return count;
+    }
+    // Paging never looks at the caches, so a block can be translated whole
+    // before any of it reaches them
+    TraceRecord recs[REPLAY_BATCH];
+    uint64_t physicalAddrs[REPLAY_BATCH];
+    bool writes[REPLAY_BATCH];
+    size_t n;
+    while ((n = readBlock(source, recs)) > 0)
+    {
+        translateBlock(target, recs, n, physicalAddrs, writes);
+        target.hierarchy->accessBatch(physicalAddrs, writes, n);
+        count += n;
+    }
+    return count;
+}
+
+uint64_t replayPipelined(TraceSource &source, const ReplayTarget &target)
+{
+    SpscRing<TraceRecord> decoded(PIPELINE_DEPTH);
+    SpscRing<PhysicalAccess> translated(PIPELINE_DEPTH);
+
+    std::thread decoder([&] {
+        std::vector<TraceRecord> batch(REPLAY_BATCH);
+        size_t n;
+        while ((n = readBlock(source, batch.data())) > 0)
+            decoded.pushBatch(batch.data(), n);
+        decoded.close();
+    });
+    std::thread translator([&] {
+        std::vector<TraceRecord> in(REPLAY_BATCH);
+        std::vector<PhysicalAccess> out(REPLAY_BATCH);
+        uint64_t physicalAddrs[REPLAY_BATCH];
+        bool writes[REPLAY_BATCH];
+        size_t n;
+        while ((n = decoded.popBatch(in.data(), REPLAY_BATCH)) > 0)
+        {
+            translateBlock(target, in.data(), n, physicalAddrs, writes);
+            for (size_t i = 0; i < n; i++)
+                out[i] = PhysicalAccess{physicalAddrs[i], writes[i]};
+            translated.pushBatch(out.data(), n);
+        }
+        translated.close();
+    });
+
+    std::vector<PhysicalAccess> batch(REPLAY_BATCH);
+    uint64_t physicalAddrs[REPLAY_BATCH];
+    bool writes[REPLAY_BATCH];
+    uint64_t count = 0;
+    size_t n;
+    while ((n = translated.popBatch(batch.data(), REPLAY_BATCH)) > 0)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            physicalAddrs[i] = batch[i].addr;
+            writes[i] = batch[i].write;
+        }
+        target.hierarchy->accessBatch(physicalAddrs, writes, n);
+        count += n;
+    }
+    translator.join();
+    decoder.join();
+    return count;
+}
+
+void SampleStats::add(double value)
+{
+    n++;
+    double delta = value - avg;
+    avg += delta / n;
+    m2 += delta * (value - avg);
+}
+
+double SampleStats::stddev() const
+{
+    return n > 1 ? std::sqrt(m2 / (n - 1)) : 0.0;
+}
+
+double SampleStats::ci95() const
+{
+    return n > 1 ? 1.96 * stddev() / std::sqrt((double)n) : 0.0;
+}
+
+namespace
+{
+    double ratio(uint64_t num, uint64_t den)
+    {
+        return den ? (double)num / den : 0.0;
+    }
+}
+
+SampledResult replaySampled(TraceSource &source, const ReplayTarget &target, const SamplingConfig &config)
+{
+    SampledResult result;
+    uint64_t window = std::min(config.window, config.period);
+    uint64_t gap = config.period - window;
+    uint64_t skip = (config.warmup == SamplingConfig::ALL_WARMUP || config.warmup >= gap) ? 0 : gap - config.warmup;
+
+    TraceRecord rec;
+    uint64_t pos = 0; // position within the current period
+    uint64_t l1Misses = 0, l1Accesses = 0, l2Misses = 0, l2Accesses = 0, faults = 0, translations = 0;
+    while (source.next(rec))
+    {
+        result.total++;
+        if (pos < skip)
+        {
+            // fast-forward: nothing but the read
+        }
+        else if (pos < gap)
+        {
+            uint64_t pAddr = processFor(target, rec.pid).warm(rec.addr, rec.write);
+            target.hierarchy->warm(pAddr, rec.write);
+            result.warmed++;
+        }
+        else
+        {
+            if (pos == gap)
+            {
+                l1Misses = target.l1->getMisses();
+                l1Accesses = l1Misses + target.l1->getHits();
+                l2Misses = target.l2->getMisses();
+                l2Accesses = l2Misses + target.l2->getHits();
+                faults = target.pm->pageFaults;
+                translations = faults + target.pm->pageHits;
+            }
+            uint64_t pAddr = processFor(target, rec.pid).translate(rec.addr, rec.write);
+            target.hierarchy->access(pAddr, rec.write);
+            result.detailed++;
+            if (pos + 1 == config.period)
+            {
+                uint64_t m1 = target.l1->getMisses(), m2 = target.l2->getMisses(), f = target.pm->pageFaults;
+                result.l1MissRate.add(ratio(m1 - l1Misses, m1 + target.l1->getHits() - l1Accesses));
+                result.l2MissRate.add(ratio(m2 - l2Misses, m2 + target.l2->getHits() - l2Accesses));
+                result.faultRate.add(ratio(f - faults, f + target.pm->pageHits - translations));
+            }
+        }
+        if (++pos == config.period)
+            pos = 0;
+    }
+    return result;
+}
+
+void printSampled(const SampledResult &result, const SamplingConfig &config)
+{
+    auto row = [](const char *name, const SampleStats &s) {
+        std::cout << name << s.mean() * 100 << "% +/- " << s.ci95() * 100 << "% (stddev " << s.stddev() * 100 << "%)\n";
+    };
+    std::cout << "\n========== Sampled Replay ==========\n";
+    std::cout << "Period: " << config.period << " | Window: " << config.window << " | Warm-up: ";
+    if (config.warmup == SamplingConfig::ALL_WARMUP)
+        std::cout << "all\n";
+    else
+        std::cout << config.warmup << "\n";
+    std::cout << "Accesses: " << result.total << " (detailed " << result.detailed
+              << ", warmed " << result.warmed
+              << ", skipped " << result.total - result.detailed - result.warmed << ")\n";
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Detailed Fraction: " << (result.total ? 100.0 * result.detailed / result.total : 0.0) << "%\n";
+    std::cout << "Windows Measured: " << result.l1MissRate.count() << "\n";
+    if (result.l1MissRate.count() == 0)
+    {
+        std::cout << "Trace shorter than one period; no window completed.\n";
+    }
+    else
+    {
+        std::cout << "Metrics (mean +/- 95% CI over windows):\n";
+        row("  L1 Miss Rate:       ", result.l1MissRate);
+        row("  L2 Local Miss Rate: ", result.l2MissRate);
+        row("  Page Fault Rate:    ", result.faultRate);
+    }
+    std::cout << "====================================\n";
+}
@@ -0,0 +1,94 @@
+#include "sampler.h"
+#include <iostream>
+#include <cstdio>
+
+IntervalSampler::IntervalSampler(const std::string &path, uint64_t interval_)
+    : out(nullptr), interval(interval_ == 0 ? 1 : interval_), nextSample(interval)
+{
+    if (path == "-")
+    {
+        out = &std::cout;
+    }
+    else
+    {
+        file.open(path);
+        if (file)
+            out = &file;
+    }
+}
+
+IntervalSampler::~IntervalSampler()
+{
+    finish();
+}
+
+bool IntervalSampler::isOpen() const
+{
+    return out != nullptr;
+}
+
+void IntervalSampler::addGauge(const std::string &name, std::function<double()> fn)
+{
+    gauges.push_back({name, std::move(fn)});
+}
+
+void IntervalSampler::addRate(const std::string &name, std::function<uint64_t()> numerator,
+                              std::function<uint64_t()> denominator)
+{
+    Rate rate;
+    rate.name = name;
+    rate.numerator = std::move(numerator);
+    rate.denominator = std::move(denominator);
+    rate.lastNumerator = rate.numerator();
+    rate.lastDenominator = rate.denominator();
+    rates.push_back(std::move(rate));
+}
+
+void IntervalSampler::finish()
+{
+    if (events > lastSampled)
+        sample();
+    if (out)
+        out->flush();
+}
+
+void IntervalSampler::sample()
+{
+    nextSample = events + interval;
+    lastSampled = events;
+    if (!out)
+        return;
+    if (!headerWritten)
+    {
+        *out << "events";
+        for (const auto &r : rates)
+            *out << "," << r.name;
+        for (const auto &g : gauges)
+            *out << "," << g.name;
+        *out << "\n";
+        headerWritten = true;
+    }
+
+    char buf[32];
+    *out << events;
+    for (auto &r : rates)
+    {
+        uint64_t num = r.numerator();
+        uint64_t den = r.denominator();
+        // counters restart from zero when the subsystem is re-initialised
+        if (num < r.lastNumerator || den < r.lastDenominator)
+            r.lastNumerator = r.lastDenominator = 0;
+        uint64_t dNum = num - r.lastNumerator;
+        uint64_t dDen = den - r.lastDenominator;
+        r.lastNumerator = num;
+        r.lastDenominator = den;
+        std::snprintf(buf, sizeof(buf), "%.4f", dDen == 0 ? 0.0 : (double)dNum / dDen);
+        *out << "," << buf;
+    }
+    for (const auto &g : gauges)
+    {
+        std::snprintf(buf, sizeof(buf), "%.4f", g.fn());
+        *out << "," << buf;
+    }
+    *out << "\n";
+}
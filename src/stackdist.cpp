@@ -0,0 +1,212 @@
+#include "stackdist.h"
+#include <algorithm>
+#include <iomanip>
+
+FenwickTree::FenwickTree(size_t size)
+    : tree(size + 1, 0)
+{
+}
+
+void FenwickTree::add(size_t index, int64_t delta)
+{
+    for (size_t i = index + 1; i < tree.size(); i += i & (~i + 1))
+        tree[i] += delta;
+}
+
+int64_t FenwickTree::prefix(size_t index) const
+{
+    int64_t sum = 0;
+    for (size_t i = index + 1; i > 0; i -= i & (~i + 1))
+        sum += tree[i];
+    return sum;
+}
+
+size_t FenwickTree::size() const
+{
+    return tree.size() - 1;
+}
+
+StackDistance::StackDistance()
+    : marks(1024)
+{
+}
+
+void StackDistance::compact()
+{
+    // renumber the live timestamps 0..n-1 in order and leave as much room again
+    std::vector<std::pair<uint64_t, PageId>> live;
+    live.reserve(lastUse.size());
+    for (const auto &entry : lastUse)
+        live.push_back({entry.second, entry.first});
+    std::sort(live.begin(), live.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+    marks = FenwickTree(std::max<size_t>(1024, 2 * live.size()));
+    for (size_t i = 0; i < live.size(); i++)
+    {
+        lastUse[live[i].second] = i;
+        marks.add(i, 1);
+    }
+    now = live.size();
+}
+
+uint64_t StackDistance::reference(const PageId &page)
+{
+    if (now == marks.size())
+        compact();
+    total++;
+    auto it = lastUse.find(page);
+    if (it == lastUse.end())
+    {
+        cold++;
+        lastUse.emplace(page, now);
+        marks.add(now++, 1);
+        return 0;
+    }
+    // marks at or after the previous use: one per distinct page since then
+    uint64_t previous = it->second;
+    uint64_t distance = lastUse.size() - marks.prefix(previous) + 1;
+    marks.add(previous, -1);
+    it->second = now;
+    marks.add(now++, 1);
+    if (histogram.size() <= distance)
+        histogram.resize(distance + 1, 0);
+    histogram[distance]++;
+    return distance;
+}
+
+uint64_t StackDistance::faults(size_t frames) const
+{
+    uint64_t result = cold;
+    for (size_t d = frames + 1; d < histogram.size(); d++)
+        result += histogram[d];
+    return result;
+}
+
+uint64_t StackDistance::references() const
+{
+    return total;
+}
+
+uint64_t StackDistance::coldFaults() const
+{
+    return cold;
+}
+
+size_t StackDistance::distinctPages() const
+{
+    return lastUse.size();
+}
+
+const std::vector<uint64_t> &StackDistance::distances() const
+{
+    return histogram;
+}
+
+FaultCurve::FaultCurve(size_t maxFrames)
+    : limit(maxFrames)
+{
+    for (size_t f = 1; f <= limit; f *= 2)
+        fifo.push_back(Fifo{f, {}, {}, 0});
+}
+
+size_t FaultCurve::maxFrames() const
+{
+    return limit;
+}
+
+void FaultCurve::reference(int pid, uint64_t vpn)
+{
+    PageId page{pid, vpn};
+    global.reference(page);
+    perProcess[pid].reference(page);
+    for (Fifo &sim : fifo)
+    {
+        if (sim.resident.count(page))
+            continue;
+        sim.faults++;
+        if (sim.queue.size() == sim.frames)
+        {
+            sim.resident.erase(sim.queue.front());
+            sim.queue.pop_front();
+        }
+        sim.queue.push_back(page);
+        sim.resident.insert(page);
+    }
+}
+
+void FaultCurve::print(std::ostream &out) const
+{
+    if (global.references() == 0)
+    {
+        out << "No references recorded yet.\n";
+        return;
+    }
+    std::ios format(nullptr);
+    format.copyfmt(out);
+    bool showPids = perProcess.size() > 1;
+    out << "\n========== Fault Curve ==========\n";
+    out << "References: " << global.references() << " | Distinct Pages: " << global.distinctPages()
+        << " | Cold Faults: " << global.coldFaults() << "\n";
+    out << std::setw(8) << "Frames" << std::setw(12) << "LRU Faults" << std::setw(9) << "Fault %"
+        << std::setw(13) << "FIFO Faults";
+    if (showPids)
+    {
+        for (const auto &p : perProcess)
+            out << std::setw(10) << ("PID " + std::to_string(p.first));
+    }
+    out << "\n" << std::fixed << std::setprecision(2);
+    // past the number of distinct pages only cold faults remain
+    for (size_t f = 1, row = 0;; f *= 2, row++)
+    {
+        uint64_t faults = global.faults(f);
+        out << std::setw(8) << f << std::setw(12) << faults
+            << std::setw(8) << 100.0 * faults / global.references() << "%";
+        if (row < fifo.size())
+            out << std::setw(13) << fifo[row].faults;
+        else
+            out << std::setw(13) << "-";
+        if (showPids)
+        {
+            for (const auto &p : perProcess)
+                out << std::setw(10) << p.second.faults(f);
+        }
+        out << "\n";
+        if (f >= global.distinctPages())
+            break;
+    }
+    if (showPids)
+        out << "(PID columns: LRU faults if the process ran alone)\n";
+    out << "=================================\n";
+    out.copyfmt(format);
+}
+
+void FaultCurve::writeCsv(std::ostream &out) const
+{
+    out << "frames,lru_faults,fifo_faults";
+    for (const auto &p : perProcess)
+        out << ",pid_" << p.first;
+    out << "\n";
+
+    // with no frames every reference faults; frame f turns distance f into hits
+    std::vector<const StackDistance *> streams{&global};
+    for (const auto &p : perProcess)
+        streams.push_back(&p.second);
+    std::vector<uint64_t> faults;
+    for (const StackDistance *s : streams)
+        faults.push_back(s->references());
+    size_t row = 0;
+    for (size_t f = 1; f <= std::max<size_t>(1, global.distinctPages()); f++)
+    {
+        for (size_t s = 0; s < streams.size(); s++)
+        {
+            const auto &hist = streams[s]->distances();
+            if (f < hist.size())
+                faults[s] -= hist[f];
+        }
+        out << f << "," << faults[0] << ",";
+        if (row < fifo.size() && fifo[row].frames == f)
+            out << fifo[row++].faults;
+        for (size_t s = 1; s < streams.size(); s++)
+            out << "," << faults[s];
+        out << "\n";
+    }
+}
@@ -0,0 +1,163 @@
+#include "stats.h"
+#include <cstdio>
+
+namespace stats
+{
+    namespace
+    {
+        template <typename T>
+        T *fetch(std::map<std::string, std::unique_ptr<T>> &table, const std::string &name)
+        {
+            auto &slot = table[name];
+            if (!slot)
+                slot = std::make_unique<T>();
+            *slot = T();
+            return slot.get();
+        }
+
+        std::string formatDouble(double v)
+        {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%.6g", v);
+            return buf;
+        }
+
+        // Inclusive upper bound of histogram bucket i
+        uint64_t bucketLimit(size_t i)
+        {
+            if (i == 0)
+                return 0;
+            if (i >= 64)
+                return UINT64_MAX;
+            return (1ULL << i) - 1;
+        }
+    }
+
+    void Histogram::record(uint64_t sample)
+    {
+        if (count == 0 || sample < min)
+            min = sample;
+        if (sample > max)
+            max = sample;
+        count++;
+        sum += sample;
+        size_t bucket = 0;
+        while (bucket < 64 && (sample >> bucket) != 0)
+            bucket++;
+        buckets[bucket]++;
+    }
+
+    Counter *Registry::counter(const std::string &name) { return fetch(counters, name); }
+    Gauge *Registry::gauge(const std::string &name) { return fetch(gauges, name); }
+    LabeledCounter *Registry::labeledCounter(const std::string &name) { return fetch(labeled, name); }
+    Histogram *Registry::histogram(const std::string &name) { return fetch(histograms, name); }
+
+    CounterArray *Registry::counterArray(const std::string &name, size_t size)
+    {
+        CounterArray *arr = fetch(arrays, name);
+        arr->values.assign(size, 0);
+        return arr;
+    }
+
+    void Registry::writeJSON(std::ostream &os) const
+    {
+        os << "{\n  \"counters\": {";
+        const char *sep = "";
+        for (const auto &kv : counters)
+        {
+            os << sep << "\n    \"" << kv.first << "\": " << kv.second->value;
+            sep = ",";
+        }
+        os << "\n  },\n  \"gauges\": {";
+        sep = "";
+        for (const auto &kv : gauges)
+        {
+            os << sep << "\n    \"" << kv.first << "\": " << formatDouble(kv.second->value);
+            sep = ",";
+        }
+        os << "\n  },\n  \"arrays\": {";
+        sep = "";
+        for (const auto &kv : arrays)
+        {
+            os << sep << "\n    \"" << kv.first << "\": [";
+            const auto &values = kv.second->values;
+            for (size_t i = 0; i < values.size(); i++)
+                os << (i ? ", " : "") << values[i];
+            os << "]";
+            sep = ",";
+        }
+        os << "\n  },\n  \"labeled\": {";
+        sep = "";
+        for (const auto &kv : labeled)
+        {
+            os << sep << "\n    \"" << kv.first << "\": {";
+            const char *inner = "";
+            for (const auto &entry : kv.second->values)
+            {
+                os << inner << "\"" << entry.first << "\": " << entry.second;
+                inner = ", ";
+            }
+            os << "}";
+            sep = ",";
+        }
+        os << "\n  },\n  \"histograms\": {";
+        sep = "";
+        for (const auto &kv : histograms)
+        {
+            const Histogram &h = *kv.second;
+            os << sep << "\n    \"" << kv.first << "\": {\"count\": " << h.count
+               << ", \"sum\": " << h.sum << ", \"min\": " << h.min << ", \"max\": " << h.max
+               << ", \"buckets\": [";
+            const char *inner = "";
+            for (size_t i = 0; i < h.buckets.size(); i++)
+            {
+                if (h.buckets[i] == 0)
+                    continue;
+                os << inner << "{\"le\": " << bucketLimit(i) << ", \"count\": " << h.buckets[i] << "}";
+                inner = ", ";
+            }
+            os << "]}";
+            sep = ",";
+        }
+        os << "\n  }\n}\n";
+    }
+
+    void Registry::writeCSV(std::ostream &os) const
+    {
+        os << "kind,name,label,value\n";
+        for (const auto &kv : counters)
+            os << "counter," << kv.first << ",," << kv.second->value << "\n";
+        for (const auto &kv : gauges)
+            os << "gauge," << kv.first << ",," << formatDouble(kv.second->value) << "\n";
+        for (const auto &kv : arrays)
+        {
+            const auto &values = kv.second->values;
+            for (size_t i = 0; i < values.size(); i++)
+                os << "array," << kv.first << "," << i << "," << values[i] << "\n";
+        }
+        for (const auto &kv : labeled)
+        {
+            for (const auto &entry : kv.second->values)
+                os << "labeled," << kv.first << "," << entry.first << "," << entry.second << "\n";
+        }
+        for (const auto &kv : histograms)
+        {
+            const Histogram &h = *kv.second;
+            os << "histogram," << kv.first << ",count," << h.count << "\n";
+            os << "histogram," << kv.first << ",sum," << h.sum << "\n";
+            os << "histogram," << kv.first << ",min," << h.min << "\n";
+            os << "histogram," << kv.first << ",max," << h.max << "\n";
+            for (size_t i = 0; i < h.buckets.size(); i++)
+            {
+                if (h.buckets[i] != 0)
+                    os << "histogram," << kv.first << ",le_" << bucketLimit(i) << "," << h.buckets[i] << "\n";
+            }
+        }
+    }
+
+    Registry &global()
+    {
+        static Registry registry;
+        return registry;
+    }
+}
@@ -0,0 +1,55 @@
+#include "swap.h"
+
+SwapDevice::SwapDevice(uint64_t readLatency_, uint64_t writeLatency_, size_t queueDepth_)
+    : readLatency(readLatency_), writeLatency(writeLatency_), queueDepth(queueDepth_ == 0 ? 1 : queueDepth_)
+{
+}
+
+uint64_t SwapDevice::getReadLatency() const
+{
+    return readLatency;
+}
+
+uint64_t SwapDevice::getWriteLatency() const
+{
+    return writeLatency;
+}
+
+size_t SwapDevice::getQueueDepth() const
+{
+    return queueDepth;
+}
+
+// Returns the cycle the transfer starts
+uint64_t SwapDevice::issue(uint64_t now, uint64_t latency)
+{
+    while (!inFlight.empty() && inFlight.top() <= now)
+        inFlight.pop();
+    uint64_t start = now;
+    if (inFlight.size() == queueDepth)
+    {
+        // queue full: wait for the earliest transfer to complete
+        start = inFlight.top();
+        inFlight.pop();
+        fullStalls++;
+        fullStallCycles += start - now;
+    }
+    inFlight.push(start + latency);
+    if (inFlight.size() > peakQueue)
+        peakQueue = inFlight.size();
+    return start;
+}
+
+uint64_t SwapDevice::read(uint64_t now)
+{
+    uint64_t done = issue(now, readLatency) + readLatency;
+    reads++;
+    readCycles += done - now;
+    return done;
+}
+
+uint64_t SwapDevice::write(uint64_t now)
+{
+    writes++;
+    return issue(now, writeLatency);
+}
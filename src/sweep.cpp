@@ -0,0 +1,127 @@
+#include "sweep.h"
+#include "cache.h"
+#include "replay.h"
+#include "threadpool.h"
+#include <iostream>
+#include <iomanip>
+
+namespace
+{
+    bool isPowerOfTwo(uint64_t n)
+    {
+        return (n > 0) && ((n & (n - 1)) == 0);
+    }
+
+    // Same rules as Integrated-mode init
+    std::string validate(const SweepConfig &c)
+    {
+        if (!isPowerOfTwo(c.ram) || !isPowerOfTwo(c.page) || !isPowerOfTwo(c.l1) || !isPowerOfTwo(c.l2) ||
+            !isPowerOfTwo(c.block) || !isPowerOfTwo(c.assoc))
+            return "sizes must be powers of 2";
+        if (c.ram <= c.page)
+            return "RAM <= page size";
+        if ((size_t)c.assoc > c.l1 / c.block || (size_t)c.assoc > c.l2 / c.block)
+            return "assoc > size/block";
+        return std::string();
+    }
+
+    double percent(uint64_t part, uint64_t whole)
+    {
+        return whole ? 100.0 * part / whole : 0.0;
+    }
+}
+
+std::vector<uint64_t> *SweepGrid::param(const std::string &name)
+{
+    if (name == "ram")
+        return &ram;
+    if (name == "page")
+        return &page;
+    if (name == "l1")
+        return &l1;
+    if (name == "l2")
+        return &l2;
+    if (name == "block")
+        return &block;
+    if (name == "assoc")
+        return &assoc;
+    if (name == "policy")
+        return &policy;
+    return nullptr;
+}
+
+std::vector<SweepConfig> SweepGrid::expand() const
+{
+    std::vector<SweepConfig> configs;
+    for (uint64_t r : ram)
+        for (uint64_t p : page)
+            for (uint64_t a : l1)
+                for (uint64_t b : l2)
+                    for (uint64_t blk : block)
+                        for (uint64_t as : assoc)
+                            for (uint64_t pol : policy)
+                                configs.push_back({r, p, a, b, blk, (int)as, pol != 0});
+    return configs;
+}
+
+SweepResult runConfig(const SweepConfig &config, const std::vector<TraceRecord> &trace)
+{
+    SweepResult result;
+    result.error = validate(config);
+    if (!result.error.empty())
+        return result;
+
+    PhysicalMemory pm(config.ram, config.page, config.lru);
+    Cache l1(config.l1, config.block, config.assoc, config.lru);
+    Cache l2(config.l2, config.block, config.assoc, config.lru);
+    cacheHierarchy hierarchy(&l1, &l2);
+    ProcessMap processes;
+    ReplayTarget target{&pm, &l1, &l2, &hierarchy, &processes};
+    for (const TraceRecord &rec : trace)
+        hierarchy.access(processFor(target, rec.pid).translate(rec.addr, rec.write), rec.write);
+
+    result.l1Hits = l1.getHits();
+    result.l1Misses = l1.getMisses();
+    result.l2Hits = l2.getHits();
+    result.l2Misses = l2.getMisses();
+    result.faults = pm.pageFaults;
+    result.translations = pm.pageFaults + pm.pageHits;
+    result.aat = hierarchy.averageAccessTime();
+    return result;
+}
+
+std::vector<SweepResult> runSweep(const std::vector<SweepConfig> &configs, const std::vector<TraceRecord> &trace, unsigned threads)
+{
+    std::vector<SweepResult> results(configs.size());
+    WorkStealingPool pool(threads);
+    for (size_t i = 0; i < configs.size(); i++)
+        pool.submit([&, i] { results[i] = runConfig(configs[i], trace); });
+    pool.wait();
+    return results;
+}
+
+void printSweep(const std::vector<SweepConfig> &configs, const std::vector<SweepResult> &results)
+{
+    std::cout << "\n" << std::setw(4) << "#" << std::setw(9) << "RAM" << std::setw(7) << "Page"
+              << std::setw(7) << "L1" << std::setw(8) << "L2" << std::setw(5) << "Blk" << std::setw(5) << "Asc"
+              << std::setw(5) << "Pol" << " |" << std::setw(8) << "L1 Hit%" << std::setw(8) << "L2 Hit%"
+              << std::setw(9) << "Faults" << std::setw(8) << "Fault%" << std::setw(8) << "AAT" << "\n";
+    std::cout << std::fixed << std::setprecision(2);
+    for (size_t i = 0; i < configs.size(); i++)
+    {
+        const SweepConfig &c = configs[i];
+        const SweepResult &r = results[i];
+        std::cout << std::setw(4) << i + 1 << std::setw(9) << c.ram << std::setw(7) << c.page
+                  << std::setw(7) << c.l1 << std::setw(8) << c.l2 << std::setw(5) << c.block << std::setw(5) << c.assoc
+                  << std::setw(5) << (c.lru ? "LRU" : "FIFO") << " |";
+        if (!r.error.empty())
+        {
+            std::cout << " invalid: " << r.error << "\n";
+            continue;
+        }
+        std::cout << std::setw(8) << percent(r.l1Hits, r.l1Hits + r.l1Misses)
+                  << std::setw(8) << percent(r.l2Hits, r.l2Hits + r.l2Misses)
+                  << std::setw(9) << r.faults << std::setw(8) << percent(r.faults, r.translations)
+                  << std::setw(8) << r.aat << "\n";
+    }
+}
@@ -0,0 +1,102 @@
+#include "threadpool.h"
+
+WorkStealingPool::WorkStealingPool(unsigned threads)
+{
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 1;
+    for (unsigned i = 0; i < threads; i++)
+        queues.push_back(std::make_unique<TaskQueue>());
+    for (unsigned i = 0; i < threads; i++)
+        workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(idleMtx);
+        stopping = true;
+    }
+    idleCv.notify_all();
+    for (auto &t : workers)
+        t.join();
+}
+
+unsigned WorkStealingPool::size() const
+{
+    return (unsigned)workers.size();
+}
+
+void WorkStealingPool::submit(std::function<void()> task)
+{
+    TaskQueue &q = *queues[nextQueue];
+    nextQueue = (nextQueue + 1) % queues.size();
+    {
+        std::lock_guard<std::mutex> lock(q.mtx);
+        q.tasks.push_back(std::move(task));
+    }
+    unfinished++;
+    {
+        // taken so a worker cannot miss the wake-up between its check and its wait
+        std::lock_guard<std::mutex> lock(idleMtx);
+        queued++;
+    }
+    idleCv.notify_one();
+}
+
+void WorkStealingPool::wait()
+{
+    std::unique_lock<std::mutex> lock(idleMtx);
+    doneCv.wait(lock, [this] { return unfinished == 0; });
+}
+
+bool WorkStealingPool::popLocal(size_t worker, std::function<void()> &task)
+{
+    TaskQueue &q = *queues[worker];
+    std::lock_guard<std::mutex> lock(q.mtx);
+    if (q.tasks.empty())
+        return false;
+    task = std::move(q.tasks.back());
+    q.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::steal(size_t worker, std::function<void()> &task)
+{
+    for (size_t k = 1; k < queues.size(); k++)
+    {
+        TaskQueue &q = *queues[(worker + k) % queues.size()];
+        std::lock_guard<std::mutex> lock(q.mtx);
+        if (q.tasks.empty())
+            continue;
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::workerLoop(size_t worker)
+{
+    std::function<void()> task;
+    while (true)
+    {
+        if (popLocal(worker, task) || steal(worker, task))
+        {
+            queued--;
+            task();
+            task = nullptr;
+            if (--unfinished == 0)
+            {
+                std::lock_guard<std::mutex> lock(idleMtx);
+                doneCv.notify_all();
+            }
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(idleMtx);
+        idleCv.wait(lock, [this] { return stopping || queued > 0; });
+        if (stopping && queued == 0)
+            return;
+    }
+}
@@ -0,0 +1,106 @@
+#include "trace.h"
+#include <cstdlib>
+#include <cctype>
+
+void TraceSource::skip(uint64_t count)
+{
+    TraceRecord rec;
+    while (count-- > 0 && next(rec))
+    {
+    }
+}
+
+std::string TraceSource::error() const
+{
+    return std::string();
+}
+
+TextTraceSource::TextTraceSource(const std::string &path)
+    : in(path)
+{
+}
+
+bool TextTraceSource::isOpen() const
+{
+    return (bool)in;
+}
+
+bool TextTraceSource::next(TraceRecord &rec)
+{
+    while (std::getline(in, line))
+    {
+        const char *p = line.c_str();
+        while (std::isspace((unsigned char)*p))
+            p++;
+        bool isAccess = false;
+        if (std::isalpha((unsigned char)*p))
+        {
+            const char *word = p;
+            while (std::isalpha((unsigned char)*p))
+                p++;
+            std::string cmd(word, p);
+            if (cmd == "back")
+                atMenu = true;
+            if (cmd != "access")
+                continue;
+            isAccess = true;
+        }
+
+        // up to three unsigned numeric fields
+        uint64_t v[3];
+        int n = 0;
+        while (n < 3)
+        {
+            char *end;
+            while (*p == ' ' || *p == '\t')
+                p++;
+            if (!std::isdigit((unsigned char)*p))
+                break;
+            v[n++] = std::strtoull(p, &end, 10);
+            p = end;
+        }
+        if (n == 0)
+            continue;
+
+        if (!isAccess && n == 1)
+        {
+            // menu choice selects how the following access lines are read
+            if (atMenu)
+            {
+                mode = (int)v[0];
+                atMenu = false;
+            }
+            continue;
+        }
+        if (isAccess && mode == 2 && n >= 2)
+        {
+            rec.pid = 0;
+            rec.addr = v[0];
+            rec.write = v[1] != 0;
+        }
+        else if (isAccess && mode == 3 && n >= 2)
+        {
+            rec.pid = (int)v[0];
+            rec.addr = v[1];
+            rec.write = n == 3 && v[2] != 0;
+        }
+        else if (n == 3)
+        {
+            rec.pid = (int)v[0];
+            rec.addr = v[1];
+            rec.write = v[2] != 0;
+        }
+        else if (n == 2)
+        {
+            rec.pid = 0;
+            rec.addr = v[0];
+            rec.write = v[1] != 0;
+        }
+        else
+        {
+            continue;
+        }
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,412 @@
+#include "tracefile.h"
+#include <cstring>
+
+namespace
+{
+    const char MAGIC[8] = {'M', 'S', 'I', 'M', 'T', 'R', 'C', '1'};
+    const char INDEX_MAGIC[8] = {'M', 'S', 'I', 'M', 'T', 'I', 'D', 'X'};
+    const uint32_t VERSION = 1;
+    const size_t HEADER_SIZE = sizeof(MAGIC) + 2 * sizeof(uint32_t);
+    const size_t CHUNK_HEADER_SIZE = 2 * sizeof(uint32_t);
+    const size_t FOOTER_SIZE = 3 * sizeof(uint64_t) + sizeof(INDEX_MAGIC);
+    const size_t RING_CAPACITY = 1 << 16;
+    const size_t BATCH = 1024;
+
+    const uint64_t FLAG_WRITE = 1;
+    const uint64_t FLAG_PID = 2;
+    const uint64_t FLAG_WIDE = 4;
+    const int FLAG_BITS = 3;
+
+    void putVarint(std::vector<uint8_t> &buf, uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            buf.push_back((uint8_t)(v | 0x80));
+            v >>= 7;
+        }
+        buf.push_back((uint8_t)v);
+    }
+
+    bool getVarint(const uint8_t *&p, const uint8_t *end, uint64_t &v)
+    {
+        v = 0;
+        for (int shift = 0; shift < 64 && p < end; shift += 7)
+        {
+            uint8_t byte = *p++;
+            v |= (uint64_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+    uint64_t zigzag(int64_t v)
+    {
+        return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+    }
+
+    int64_t unzigzag(uint64_t v)
+    {
+        return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+    }
+
+    template <typename T>
+    void writeLE(std::ofstream &out, T v)
+    {
+        uint8_t bytes[sizeof(T)];
+        for (size_t i = 0; i < sizeof(T); i++)
+            bytes[i] = (uint8_t)(v >> (8 * i));
+        out.write(reinterpret_cast<const char *>(bytes), sizeof(T));
+    }
+
+    template <typename T>
+    T readLE(const uint8_t *p)
+    {
+        T v = 0;
+        for (size_t i = 0; i < sizeof(T); i++)
+            v |= (T)p[i] << (8 * i);
+        return v;
+    }
+}
+
+BinaryTraceWriter::BinaryTraceWriter(const std::string &path, uint32_t chunkRecords_)
+    : out(path, std::ios::binary), chunkRecords(chunkRecords_ == 0 ? 1 : chunkRecords_)
+{
+    if (!out)
+        return;
+    out.write(MAGIC, sizeof(MAGIC));
+    writeLE<uint32_t>(out, VERSION);
+    writeLE<uint32_t>(out, chunkRecords);
+    offset = HEADER_SIZE;
+}
+
+BinaryTraceWriter::~BinaryTraceWriter()
+{
+    if (!closed)
+        close();
+}
+
+bool BinaryTraceWriter::isOpen() const
+{
+    return (bool)out;
+}
+
+uint64_t BinaryTraceWriter::records() const
+{
+    return total;
+}
+
+uint64_t BinaryTraceWriter::bytesWritten() const
+{
+    return offset;
+}
+
+void BinaryTraceWriter::add(const TraceRecord &rec)
+{
+    if (inChunk == 0)
+    {
+        index.push_back({offset, total});
+        lastPid = 0;
+        lastAddr.clear();
+    }
+    uint64_t &prev = lastAddr[rec.pid];
+    uint64_t delta = zigzag((int64_t)(rec.addr - prev));
+    prev = rec.addr;
+
+    uint64_t tag = rec.write ? FLAG_WRITE : 0;
+    if (rec.pid != lastPid)
+        tag |= FLAG_PID;
+    bool wide = delta >> (64 - FLAG_BITS) != 0;
+    if (wide)
+        tag |= FLAG_WIDE;
+    else
+        tag |= delta << FLAG_BITS;
+    putVarint(payload, tag);
+    if (rec.pid != lastPid)
+        putVarint(payload, zigzag(rec.pid));
+    if (wide)
+        putVarint(payload, delta);
+    lastPid = rec.pid;
+
+    total++;
+    if (++inChunk == chunkRecords)
+        flushChunk();
+}
+
+void BinaryTraceWriter::flushChunk()
+{
+    if (inChunk == 0)
+        return;
+    writeLE<uint32_t>(out, (uint32_t)payload.size());
+    writeLE<uint32_t>(out, inChunk);
+    out.write(reinterpret_cast<const char *>(payload.data()), payload.size());
+    offset += CHUNK_HEADER_SIZE + payload.size();
+    payload.clear();
+    inChunk = 0;
+}
+
+bool BinaryTraceWriter::close()
+{
+    if (closed)
+        return (bool)out;
+    closed = true;
+    flushChunk();
+    uint64_t indexOffset = offset;
+    for (const auto &entry : index)
+    {
+        writeLE<uint64_t>(out, entry.first);
+        writeLE<uint64_t>(out, entry.second);
+    }
+    writeLE<uint64_t>(out, indexOffset);
+    writeLE<uint64_t>(out, index.size());
+    writeLE<uint64_t>(out, total);
+    out.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    offset += index.size() * 2 * sizeof(uint64_t) + FOOTER_SIZE;
+    out.flush();
+    return (bool)out;
+}
+
+BinaryTraceSource::~BinaryTraceSource()
+{
+    stop();
+}
+
+bool BinaryTraceSource::open(const std::string &path_)
+{
+    path = path_;
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in)
+    {
+        message = "could not open " + path;
+        return false;
+    }
+    uint64_t size = (uint64_t)in.tellg();
+    uint8_t header[HEADER_SIZE];
+    uint8_t footer[FOOTER_SIZE];
+    in.seekg(0);
+    if (size < HEADER_SIZE + FOOTER_SIZE || !in.read(reinterpret_cast<char *>(header), HEADER_SIZE) ||
+        std::memcmp(header, MAGIC, sizeof(MAGIC)) != 0)
+    {
+        message = "not a memsim trace";
+        return false;
+    }
+    uint32_t version = readLE<uint32_t>(header + sizeof(MAGIC));
+    if (version != VERSION)
+    {
+        message = "unsupported trace version " + std::to_string(version);
+        return false;
+    }
+    in.seekg(size - FOOTER_SIZE);
+    if (!in.read(reinterpret_cast<char *>(footer), FOOTER_SIZE) ||
+        std::memcmp(footer + 3 * sizeof(uint64_t), INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0)
+    {
+        message = "trace index missing (file truncated?)";
+        return false;
+    }
+    indexOffset = readLE<uint64_t>(footer);
+    uint64_t count = readLE<uint64_t>(footer + 8);
+    total = readLE<uint64_t>(footer + 16);
+    if (indexOffset < HEADER_SIZE || indexOffset > size - FOOTER_SIZE ||
+        count != (size - FOOTER_SIZE - indexOffset) / 16 || (count == 0) != (total == 0))
+    {
+        message = "corrupt trace index";
+        return false;
+    }
+    std::vector<uint8_t> raw(count * 16);
+    in.seekg(indexOffset);
+    if (!in.read(reinterpret_cast<char *>(raw.data()), raw.size()))
+    {
+        message = "corrupt trace index";
+        return false;
+    }
+    chunks.clear();
+    for (uint64_t i = 0; i < count; i++)
+    {
+        ChunkEntry entry{readLE<uint64_t>(&raw[i * 16]), readLE<uint64_t>(&raw[i * 16 + 8])};
+        bool ordered = chunks.empty() ? entry.firstRecord == 0
+                                      : (entry.offset > chunks.back().offset && entry.firstRecord > chunks.back().firstRecord);
+        if (!ordered || entry.offset >= indexOffset || entry.firstRecord >= total)
+        {
+            message = "corrupt trace index";
+            return false;
+        }
+        chunks.push_back(entry);
+    }
+    return true;
+}
+
+uint64_t BinaryTraceSource::records() const
+{
+    return total;
+}
+
+std::string BinaryTraceSource::error() const
+{
+    return message;
+}
+
+void BinaryTraceSource::start(uint64_t record)
+{
+    stop();
+    position = record;
+    batch.assign(BATCH, TraceRecord());
+    batchPos = batchLen = 0;
+    decodeError.clear();
+    ring = std::make_unique<SpscRing<TraceRecord>>(RING_CAPACITY);
+    started = true;
+    if (record >= total)
+    {
+        ring->close();
+        return;
+    }
+    // last chunk whose first record is <= record
+    size_t lo = 0, hi = chunks.size();
+    while (hi - lo > 1)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (chunks[mid].firstRecord <= record)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    decoder = std::thread(&BinaryTraceSource::produce, this, lo, record - chunks[lo].firstRecord);
+}
+
+void BinaryTraceSource::stop()
+{
+    if (ring)
+        ring->cancel();
+    if (decoder.joinable())
+        decoder.join();
+    started = false;
+}
+
+void BinaryTraceSource::produce(size_t chunk, uint64_t skipInChunk)
+{
+    std::ifstream in(path, std::ios::binary);
+    std::vector<uint8_t> payload;
+    for (; chunk < chunks.size(); chunk++)
+    {
+        uint8_t head[CHUNK_HEADER_SIZE];
+        in.seekg(chunks[chunk].offset);
+        if (!in.read(reinterpret_cast<char *>(head), CHUNK_HEADER_SIZE))
+        {
+            decodeError = "truncated trace chunk";
+            break;
+        }
+        uint32_t bytes = readLE<uint32_t>(head);
+        uint32_t count = readLE<uint32_t>(head + 4);
+        uint64_t limit = chunk + 1 < chunks.size() ? chunks[chunk + 1].offset : indexOffset;
+        if (chunks[chunk].offset + CHUNK_HEADER_SIZE + bytes > limit)
+        {
+            decodeError = "corrupt trace chunk";
+            break;
+        }
+        payload.resize(bytes);
+        if (!in.read(reinterpret_cast<char *>(payload.data()), bytes))
+        {
+            decodeError = "truncated trace chunk";
+            break;
+        }
+
+        const uint8_t *p = payload.data();
+        const uint8_t *end = p + payload.size();
+        int pid = 0;
+        std::unordered_map<int, uint64_t> lastAddr;
+        uint32_t i = 0;
+        for (; i < count; i++)
+        {
+            uint64_t tag, value, delta;
+            if (!getVarint(p, end, tag))
+                break;
+            if (tag & FLAG_PID)
+            {
+                if (!getVarint(p, end, value))
+                    break;
+                pid = (int)unzigzag(value);
+            }
+            if (tag & FLAG_WIDE)
+            {
+                if (!getVarint(p, end, delta))
+                    break;
+            }
+            else
+            {
+                delta = tag >> FLAG_BITS;
+            }
+            uint64_t &prev = lastAddr[pid];
+            prev += (uint64_t)unzigzag(delta);
+            if (skipInChunk > 0)
+            {
+                skipInChunk--;
+                continue;
+            }
+            if (!ring->push({pid, prev, (tag & FLAG_WRITE) != 0}))
+                return; // consumer went away
+        }
+        if (i != count || p != end)
+        {
+            decodeError = "corrupt trace chunk";
+            break;
+        }
+    }
+    ring->close();
+}
+
+bool BinaryTraceSource::next(TraceRecord &rec)
+{
+    if (!started)
+        start(position);
+    if (batchPos == batchLen)
+    {
+        batchPos = 0;
+        batchLen = ring->popBatch(batch.data(), batch.size());
+        if (batchLen == 0)
+        {
+            // the decoder closed the ring, so its error string is settled
+            if (!decodeError.empty() && message.empty())
+                message = decodeError;
+            return false;
+        }
+    }
+    rec = batch[batchPos++];
+    position++;
+    return true;
+}
+
+void BinaryTraceSource::skip(uint64_t count)
+{
+    uint64_t buffered = started ? batchLen - batchPos : 0;
+    if (count <= buffered)
+    {
+        batchPos += count;
+        position += count;
+        return;
+    }
+    start(position + count);
+}
+
+std::unique_ptr<TraceSource> openTraceSource(const std::string &path, std::string &error)
+{
+    char magic[sizeof(MAGIC)] = {};
+    {
+        std::ifstream probe(path, std::ios::binary);
+        if (!probe)
+        {
+            error = "Could not open " + path;
+            return nullptr;
+        }
+        probe.read(magic, sizeof(magic));
+    }
+    if (std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0)
+    {
+        auto source = std::make_unique<BinaryTraceSource>();
+        if (!source->open(path))
+        {
+            error = source->error();
+            return nullptr;
+        }
+        return source;
+    }
+    return std::make_unique<TextTraceSource>(path);
+}
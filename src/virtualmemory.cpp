@@ -1,11 +1,18 @@
 #include "virtualmemory.h"
 #include <iomanip>
+#include <algorithm>
 
 PhysicalMemory::PhysicalMemory(size_t ramSize, size_t pageSize, bool useLRU_)
-    :  pagesize(pageSize),isLRU(useLRU_)
+    : PhysicalMemory(ramSize, pageSize, useLRU_ ? ReplacementKind::LRU : ReplacementKind::FIFO)
+{
+}
+
+PhysicalMemory::PhysicalMemory(size_t ramSize, size_t pageSize, ReplacementKind kind_)
+    : pagesize(pageSize), isLRU(kind_ == ReplacementKind::LRU), kind(kind_)
 {
     numFrames = ramSize / pagesize;
-    frames.resize(numFrames);
+    frames.reset(numFrames);
+    policy = makePagePolicy(kind, numFrames);
 }
 
 void PhysicalMemory::registerProcess(int pid, VirtualMemory *vm)
@@ -13,8 +20,148 @@ void PhysicalMemory::registerProcess(int pid, VirtualMemory *vm)
     processRegistry[pid] = vm;
 }
 
-void PhysicalMemory::access(int frameIndex)
+void PhysicalMemory::unregisterProcess(int pid)
+{
+    processRegistry.erase(pid);
+    for (auto it = swapped.begin(); it != swapped.end();)
+        it = it->pid == pid ? swapped.erase(it) : std::next(it);
+}
+
+void PhysicalMemory::share(FrameNumber frameIndex, int pid, uint64_t vpn)
+{
+    frames[frameIndex].refCount++;
+    sharers[frameIndex].push_back(PageId{pid, vpn});
+}
+
+void PhysicalMemory::unmap(FrameNumber frameIndex, int pid, uint64_t vpn)
+{
+    // the page's swap copy is stale from now on either way
+    swapped.erase(PageId{pid, vpn});
+    FrameInfo &frame = frames[frameIndex];
+    if (frame.refCount <= 1)
+    {
+        releaseFrame(frameIndex);
+        return;
+    }
+    frame.refCount--;
+    auto it = sharers.find(frameIndex);
+    std::vector<PageId> &others = it->second;
+    if (frame.ownerPID == pid && frame.ownerVPN == vpn)
+    {
+        frame.ownerPID = others.back().pid;
+        frame.ownerVPN = others.back().vpn;
+        others.pop_back();
+    }
+    else
+    {
+        auto self = std::find(others.begin(), others.end(), PageId{pid, vpn});
+        *self = others.back();
+        others.pop_back();
+    }
+    if (others.empty())
+        sharers.erase(it);
+}
+
+uint32_t PhysicalMemory::refCount(FrameNumber frameIndex) const
+{
+    return frames[frameIndex].refCount;
+}
+
+bool PhysicalMemory::mapsPage(FrameNumber frameIndex, int pid, uint64_t vpn) const
+{
+    if (frameIndex < 0 || (size_t)frameIndex >= numFrames || !frames[frameIndex].used())
+        return false;
+    bool mapped = false;
+    forEachMapping(frameIndex, [&](int owner, uint64_t page) { mapped |= owner == pid && page == vpn; });
+    return mapped;
+}
+
+void PhysicalMemory::inheritSwapped(const PageId &parent, const PageId &child)
+{
+    if (swapped.count(parent))
+        swapped.insert(child);
+}
+
+size_t PhysicalMemory::sharedFrames() const
+{
+    return sharers.size();
+}
+
+FrameNumber PhysicalMemory::takeFreeFrame(const PageId &page)
+{
+    if (!tiers.empty())
+        return placeNewPage();
+    if (colors)
+        return takeColoredFrame(page);
+    if (!freeFrames.empty())
+    {
+        FrameNumber frame = freeFrames.back();
+        freeFrames.pop_back();
+        return frame;
+    }
+    return (FrameNumber)nextFreeFrameIndex++;
+}
+
+void PhysicalMemory::releaseFrame(FrameNumber frame)
+{
+    frames[frame] = FrameInfo();
+    if (policy)
+        policy->remove(frame);
+    else if (isLRU)
+    {
+        lruList.erase(lruMap[frame]);
+        lruMap.erase(frame);
+    }
+    if (!tiers.empty())
+    {
+        heat[frame] = 0;
+        tiers[tierOf(frame)].freeFrames.push_back(frame);
+    }
+    else if (colors)
+    {
+        colorFree[frame % colors].push_back(frame);
+    }
+    else
+    {
+        freeFrames.push_back(frame);
+    }
+    usedFrames--;
+    framesFreed++;
+}
+
+// Invalidates every page mapped to frame before it is reused
+void PhysicalMemory::evictFrame(FrameNumber frame, bool detailed)
 {
+    if (!frames[frame].used())
+        return;
+    STAT_INC(statEvictions);
+    STAT_INC_LABEL(statEvictionsByPid, frames[frame].ownerPID);
+    bool dirty = false;
+    forEachMapping(frame, [&](int pid, uint64_t vpn) {
+        auto it = processRegistry.find(pid);
+        if (it != processRegistry.end())
+            dirty |= it->second->invalidatePage(vpn);
+    });
+    sharers.erase(frame);
+    // a clean page keeps any copy it already has on the device
+    if (swap && dirty)
+    {
+        forEachMapping(frame, [&](int pid, uint64_t vpn) { swapped.insert(PageId{pid, vpn}); });
+        if (detailed)
+        {
+            clock = swap->write(clock);
+            STAT_INC(statSwapOuts);
+        }
+    }
+}
+
+void PhysicalMemory::access(FrameNumber frameIndex)
+{
+    if (policy)
+    {
+        policy->touch(frameIndex);
+        return;
+    }
     if (!isLRU)
         return;
     auto it = lruMap.find(frameIndex);
@@ -24,15 +171,34 @@ void PhysicalMemory::access(int frameIndex)
     }
 }
 
-int PhysicalMemory::allocate(int ownerPID, uint64_t ownerVPN)
+void PhysicalMemory::attachSwap(std::unique_ptr<SwapDevice> device)
+{
+    swap = std::move(device);
+    swapped.clear();
+}
+
+const SwapDevice *PhysicalMemory::swapDevice() const
+{
+    return swap.get();
+}
+
+void PhysicalMemory::attachCurve(std::unique_ptr<FaultCurve> curve_)
+{
+    curve = std::move(curve_);
+}
+
+FaultCurve *PhysicalMemory::faultCurve() const
 {
-    int targetFrame = -1;
-    if (!isFull)
+    return curve.get();
+}
+
+FrameNumber PhysicalMemory::allocate(int ownerPID, uint64_t ownerVPN, bool detailed)
+{
+    FrameNumber targetFrame = -1;
+    if (usedFrames < numFrames)
     {
-        targetFrame = nextFreeFrameIndex;
-        nextFreeFrameIndex++;
-        if (nextFreeFrameIndex == numFrames)
-            isFull = true;
+        targetFrame = takeFreeFrame(PageId{ownerPID, ownerVPN});
+        usedFrames++;
 
         if (isLRU)
         {
@@ -42,7 +208,11 @@ int PhysicalMemory::allocate(int ownerPID, uint64_t ownerVPN)
     }
     else
     {
-        if (!isLRU)
+        if (policy)
+        {
+            targetFrame = policy->victim(PageId{ownerPID, ownerVPN});
+        }
+        else if (!isLRU)
         {
             targetFrame = fifoPointer;
             fifoPointer = (fifoPointer + 1) % numFrames;
@@ -55,34 +225,586 @@ int PhysicalMemory::allocate(int ownerPID, uint64_t ownerVPN)
             lruList.push_front(targetFrame);
             lruMap[targetFrame] = lruList.begin();
         }
-        if (frames[targetFrame].isUsed)
+        evictFrame(targetFrame, detailed);
+    }
+
+    if (swap && detailed)
+    {
+        // only pages that were written out need a device read; the rest are zero-filled
+        if (swapped.count(PageId{ownerPID, ownerVPN}))
+        {
+            majorFaults++;
+            STAT_INC(statMajorFaults);
+            clock = swap->read(clock);
+        }
+        else
+        {
+            minorFaults++;
+        }
+    }
+
+    FrameInfo &info = frames[targetFrame];
+    info.ownerVPN = ownerVPN;
+    info.ownerPID = ownerPID;
+    info.refCount = 1;
+    if (!tiers.empty())
+        heat[targetFrame] = 0;
+    if (policy)
+        policy->fill(targetFrame, PageId{ownerPID, ownerVPN});
+
+    return targetFrame;
+}
+
+bool PhysicalMemory::configureTiers(const std::vector<TierSpec> &specs, std::string &error)
+{
+    size_t total = 0;
+    for (size_t t = 0; t < specs.size(); t++)
+    {
+        if (specs[t].size == 0 || specs[t].size % pagesize != 0)
+        {
+            error = "Tier sizes must be non-zero multiples of the page size.";
+            return false;
+        }
+        // migrate() promotes into tier t - 1
+        if (t > 0 && specs[t].latency < specs[t - 1].latency)
+        {
+            error = "List tiers fastest first (latencies must not decrease).";
+            return false;
+        }
+        total += specs[t].size;
+    }
+    if (specs.size() < 2)
+        error = "Give at least two tiers.";
+    else if (total != ramSize())
+        error = "Tier sizes must add up to the RAM size (" + std::to_string(ramSize()) + ").";
+    else if (framesInUse() != 0)
+        error = "Tiers must be configured before the first page is mapped.";
+    else if (colors)
+        error = "Tiers cannot be combined with page coloring.";
+    if (!error.empty())
+        return false;
+
+    tiers.clear();
+    freeFrames.clear();
+    nextFreeFrameIndex = 0;
+    heat.reset(numFrames);
+    size_t first = 0;
+    for (const auto &spec : specs)
+    {
+        Tier tier;
+        tier.spec = spec;
+        tier.first = tier.next = first;
+        tier.count = spec.size / pagesize;
+        first += tier.count;
+        tiers.push_back(tier);
+    }
+    return true;
+}
+
+bool PhysicalMemory::setColoring(size_t colors_, std::string &error)
+{
+    if (!tiers.empty())
+    {
+        error = "Page coloring cannot be combined with memory tiers.";
+        return false;
+    }
+    // collect every free frame below the never-used watermark, then deal them out again
+    std::vector<FrameNumber> free;
+    nextFreeFrameIndex = freeFrameList(free);
+    std::sort(free.rbegin(), free.rend());
+    colors = colors_ > 1 ? colors_ : 0;
+    colorOffsets.clear();
+    colorFree.assign(colors, {});
+    colorNext.resize(colors);
+    freeFrames.clear();
+    for (FrameNumber frame : free)
+    {
+        if (colors)
+            colorFree[frame % colors].push_back(frame);
+        else
+            freeFrames.push_back(frame);
+    }
+    // never-used frames are handed out per color from the watermark up
+    size_t base = nextFreeFrameIndex;
+    for (size_t c = 0; c < colors; c++)
+        colorNext[c] = base + (c + colors - base % colors) % colors;
+    return true;
+}
+
+size_t PhysicalMemory::freeFrameList(std::vector<FrameNumber> &free) const
+{
+    free.insert(free.end(), freeFrames.begin(), freeFrames.end());
+    for (const auto &list : colorFree)
+        free.insert(free.end(), list.begin(), list.end());
+    if (!colors)
+        return nextFreeFrameIndex;
+    // each color's cursor marks where its never-used frames start
+    size_t low = numFrames, high = 0;
+    for (FrameNumber next : colorNext)
+    {
+        low = std::min<size_t>(low, next);
+        high = std::max<size_t>(high, next);
+    }
+    high = std::min(high, numFrames);
+    for (size_t f = low; f < high; f++)
+    {
+        if ((size_t)colorNext[f % colors] <= f)
+            free.push_back((FrameNumber)f);
+    }
+    return high;
+}
+
+size_t PhysicalMemory::colorCount() const
+{
+    return colors;
+}
+
+// Wanted color: the page's VPN plus a per-process offset. Offsets follow the
+// bit-reversed order of first faults (0, 1/2, 1/4, 3/4, ... of the colors),
+// which keeps the low pages of any number of processes as far apart as possible.
+FrameNumber PhysicalMemory::takeColoredFrame(const PageId &page)
+{
+    auto found = colorOffsets.find(page.pid);
+    if (found == colorOffsets.end())
+    {
+        size_t index = colorOffsets.size(), offset = 0;
+        for (size_t bit = colors / 2; bit; bit /= 2, index /= 2)
+            offset += (index & 1) ? bit : 0;
+        found = colorOffsets.emplace(page.pid, offset).first;
+    }
+    size_t wanted = (page.vpn + found->second) % colors;
+    coloredPages++;
+    for (size_t step = 0; step < colors; step++)
+    {
+        size_t color = (wanted + step) % colors;
+        std::vector<FrameNumber> &list = colorFree[color];
+        FrameNumber frame = -1;
+        if (!list.empty())
+        {
+            frame = list.back();
+            list.pop_back();
+        }
+        else if ((size_t)colorNext[color] < numFrames)
+        {
+            frame = colorNext[color];
+            colorNext[color] += colors;
+        }
+        else
         {
-            int victimPID = frames[targetFrame].ownerPID;
-            uint64_t victimVPN = frames[targetFrame].ownerVPN;
-            if (processRegistry.find(victimPID) != processRegistry.end())
+            continue;
+        }
+        if (step)
+            offColorPages++;
+        return frame;
+    }
+    return -1; // unreachable: allocate() only asks while frames are free
+}
+
+size_t PhysicalMemory::tierCount() const
+{
+    return tiers.size();
+}
+
+void PhysicalMemory::setPlacement(Placement placement_)
+{
+    placement = placement_;
+}
+
+void PhysicalMemory::setMigration(uint64_t epochAccesses, size_t budget)
+{
+    epochLength = epochAccesses;
+    epochBudget = budget;
+    epochTicks = 0;
+}
+
+size_t PhysicalMemory::tierOf(FrameNumber frame) const
+{
+    size_t t = 0;
+    while ((size_t)frame >= tiers[t].first + tiers[t].count)
+        t++;
+    return t;
+}
+
+bool PhysicalMemory::tierHasRoom(size_t t) const
+{
+    return !tiers[t].freeFrames.empty() || tiers[t].next < tiers[t].first + tiers[t].count;
+}
+
+FrameNumber PhysicalMemory::takeTierFrame(size_t t)
+{
+    Tier &tier = tiers[t];
+    if (!tier.freeFrames.empty())
+    {
+        FrameNumber frame = tier.freeFrames.back();
+        tier.freeFrames.pop_back();
+        return frame;
+    }
+    return (FrameNumber)tier.next++;
+}
+
+FrameNumber PhysicalMemory::placeNewPage()
+{
+    // only called while some tier has room
+    size_t t = 0;
+    if (placement == Placement::Fast)
+    {
+        while (!tierHasRoom(t))
+            t++;
+    }
+    else if (placement == Placement::Slow)
+    {
+        t = tiers.size() - 1;
+        while (!tierHasRoom(t))
+            t--;
+    }
+    else
+    {
+        t = interleaveNext;
+        while (!tierHasRoom(t))
+            t = (t + 1) % tiers.size();
+        interleaveNext = (t + 1) % tiers.size();
+    }
+    return takeTierFrame(t);
+}
+
+void PhysicalMemory::prefetchFrame(FrameNumber frameIndex) const
+{
+    if (!policy && isLRU)
+    {
+        auto it = lruMap.find(frameIndex);
+        if (it != lruMap.end())
+            __builtin_prefetch(&*it->second);
+    }
+    if (!tiers.empty())
+        heat.prefetch(frameIndex);
+}
+void PhysicalMemory::countAccess(FrameNumber frameIndex)
+{
+    if (tiers.empty())
+        return;
+    tiers[tierOf(frameIndex)].accesses++;
+    uint32_t &count = heat[frameIndex];
+    if (count != UINT32_MAX)
+        count++;
+    if (epochLength && ++epochTicks == epochLength)
+    {
+        epochTicks = 0;
+        migrate();
+    }
+}
+
+// The page in `from` moves to the free frame `to`
+void PhysicalMemory::movePage(FrameNumber from, FrameNumber to)
+{
+    frames[to] = frames[from];
+    frames[from] = FrameInfo();
+    heat[to] = heat[from];
+    heat[from] = 0;
+    moveSharers(from, to);
+    remapMappings(to);
+    if (policy)
+        policy->relocate(from, to, false);
+    else if (isLRU)
+    {
+        auto node = lruMap[from];
+        *node = to;
+        lruMap.erase(from);
+        lruMap[to] = node;
+    }
+    tiers[tierOf(from)].freeFrames.push_back(from);
+}
+
+void PhysicalMemory::moveSharers(FrameNumber from, FrameNumber to)
+{
+    auto it = sharers.find(from);
+    if (it == sharers.end())
+        return;
+    std::vector<PageId> pages;
+    pages.swap(it->second);
+    sharers.erase(it);
+    sharers[to].swap(pages);
+}
+
+void PhysicalMemory::remapMappings(FrameNumber frame)
+{
+    forEachMapping(frame, [&](int pid, uint64_t vpn) { processRegistry[pid]->remapPage(vpn, frame); });
+}
+
+void PhysicalMemory::exchangePages(FrameNumber a, FrameNumber b)
+{
+    std::swap(frames[a], frames[b]);
+    std::swap(heat[a], heat[b]);
+    auto sa = sharers.find(a), sb = sharers.find(b);
+    std::vector<PageId> fromA, fromB;
+    if (sa != sharers.end())
+    {
+        fromA.swap(sa->second);
+        sharers.erase(sa);
+    }
+    if (sb != sharers.end())
+    {
+        fromB.swap(sb->second);
+        sharers.erase(sb);
+    }
+    if (!fromA.empty())
+        sharers[b].swap(fromA);
+    if (!fromB.empty())
+        sharers[a].swap(fromB);
+    remapMappings(a);
+    remapMappings(b);
+    if (policy)
+        policy->relocate(a, b, true);
+    else if (isLRU)
+    {
+        std::swap(lruMap[a], lruMap[b]);
+        *lruMap[a] = a;
+        *lruMap[b] = b;
+    }
+}
+
+void PhysicalMemory::migrate()
+{
+    size_t budget = epochBudget;
+    const FrameTable<uint32_t> &heatOf = heat;
+    auto hotter = [&heatOf](FrameNumber x, FrameNumber y) { return heatOf[x] > heatOf[y]; };
+    auto colder = [&heatOf](FrameNumber x, FrameNumber y) { return heatOf[x] < heatOf[y]; };
+    const FrameTable<FrameInfo> &frameOf = frames;
+    for (size_t t = 1; t < tiers.size() && budget > 0; t++)
+    {
+        // the hottest pages of tier t compete for the coldest slots of tier t - 1;
+        // frames at or above a tier's next have never been used
+        std::vector<FrameNumber> hot, cold;
+        for (size_t f = tiers[t].first; f < tiers[t].next; f++)
+        {
+            if (frameOf[f].used() && heatOf[f] > 0)
+                hot.push_back((FrameNumber)f);
+        }
+        for (size_t f = tiers[t - 1].first; f < tiers[t - 1].next; f++)
+        {
+            if (frameOf[f].used())
+                cold.push_back((FrameNumber)f);
+        }
+        size_t hotCount = std::min(hot.size(), budget);
+        std::partial_sort(hot.begin(), hot.begin() + hotCount, hot.end(), hotter);
+        size_t coldCount = std::min(cold.size(), budget);
+        std::partial_sort(cold.begin(), cold.begin() + coldCount, cold.end(), colder);
+
+        size_t c = 0;
+        for (size_t h = 0; h < hotCount && budget > 0; h++, budget--)
+        {
+            if (tierHasRoom(t - 1))
             {
-                processRegistry[victimPID]->invalidatePage(victimVPN);
+                movePage(hot[h], takeTierFrame(t - 1));
+                promotions++;
+            }
+            else if (c < coldCount && heatOf[cold[c]] < heatOf[hot[h]])
+            {
+                exchangePages(hot[h], cold[c++]);
+                promotions++;
+                demotions++;
+            }
+            else
+            {
+                break;
             }
         }
     }
+    heat.forEach([](size_t, uint32_t &h) { h >>= 1; });
+}
 
-    frames[targetFrame].isUsed = true;
-    frames[targetFrame].ownerVPN = ownerVPN;
-    frames[targetFrame].ownerPID = ownerPID;
+void PhysicalMemory::printTiers() const
+{
+    uint64_t total = 0;
+    double cycles = 0;
+    for (const auto &tier : tiers)
+    {
+        total += tier.accesses;
+        cycles += (double)tier.accesses * tier.spec.latency;
+    }
+    std::ios format(nullptr);
+    format.copyfmt(std::cout);
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Tiers:\n";
+    for (size_t t = 0; t < tiers.size(); t++)
+    {
+        const Tier &tier = tiers[t];
+        size_t used = 0;
+        for (size_t f = tier.first; f < tier.next; f++)
+            used += frames[f].used();
+        std::cout << "  Tier " << t << " (" << tier.count << " frames, latency " << tier.spec.latency << "): "
+                  << used << " used | Accesses " << tier.accesses << " ("
+                  << (total ? 100.0 * tier.accesses / total : 0.0) << "%)\n";
+    }
+    std::cout << "  Avg Memory Latency: " << (total ? cycles / total : 0.0) << " cycles\n";
+    std::cout << "  Migration";
+    if (epochLength)
+        std::cout << " (every " << epochLength << " accesses, up to " << epochBudget << " pages)";
+    else
+        std::cout << " (off)";
+    std::cout << ": " << promotions << " promotions, " << demotions << " demotions, "
+              << (promotions + demotions) * pagesize << " bytes\n";
+    std::cout.copyfmt(format);
+}
 
-    return targetFrame;
+size_t PhysicalMemory::framesInUse() const
+{
+    return usedFrames;
+}
+
+size_t PhysicalMemory::allocatedFrameEntries() const
+{
+    return frames.allocatedRecords();
+}
+
+size_t PhysicalMemory::ramSize() const
+{
+    return numFrames * pagesize;
+}
+
+bool PhysicalMemory::usesLRU() const
+{
+    return isLRU;
+}
+
+ReplacementKind PhysicalMemory::replacement() const
+{
+    return kind;
 }
 
 void PhysicalMemory::printStatus()
 {
     std::cout << "--- Physical RAM Status ---\n";
-    std::cout << "Frames Used: " << (isFull ? numFrames : nextFreeFrameIndex) << "/" << numFrames << "\n";
-    for (size_t i = 0; i < numFrames; ++i)
+    std::cout << "Frames Used: " << framesInUse() << "/" << numFrames << "\n";
+    frames.forEach([](size_t i, const FrameInfo &frame) {
+        if (!frame.used())
+            return;
+        std::cout << " Frame " << i << ": PID " << frame.ownerPID << " (VPN " << frame.ownerVPN << ")";
+        if (frame.refCount > 1)
+            std::cout << " shared x" << frame.refCount;
+        std::cout << "\n";
+    });
+    std::cout << "Hits: " << pageHits << " | Faults: " << pageFaults << "\n";
+    if (forks || exits)
     {
-        if (frames[i].isUsed)
-            std::cout << " Frame " << i << ": PID " << frames[i].ownerPID << " (VPN " << frames[i].ownerVPN << ")\n";
+        size_t saved = 0;
+        for (const auto &entry : sharers)
+            saved += entry.second.size();
+        std::cout << "Forks: " << forks << " | Exits: " << exits << " | Frames Freed: " << framesFreed << "\n";
+        std::cout << "Shared Frames: " << sharers.size() << " (" << saved << " frames saved) | CoW Copies: " << cowCopies << "\n";
+    }
+    if (colors)
+        std::cout << "Page Coloring: " << colors << " colors | Colored Pages: " << coloredPages
+                  << " | Off-color: " << offColorPages << "\n";
+    if (!tiers.empty())
+        printTiers();
+    if (swap)
+    {
+        std::cout << "Minor Faults: " << minorFaults << " | Major Faults: " << majorFaults << "\n";
+        std::cout << "Swap (read " << swap->getReadLatency() << ", write " << swap->getWriteLatency()
+                  << ", depth " << swap->getQueueDepth() << "):\n";
+        std::cout << "  Swap In:  " << swap->reads << " pages (" << swap->reads * pagesize << " bytes)\n";
+        std::cout << "  Swap Out: " << swap->writes << " pages (" << swap->writes * pagesize << " bytes)\n";
+        std::cout << "  Avg Major Fault Latency: " << (swap->reads ? swap->readCycles / swap->reads : 0) << " cycles\n";
+        std::cout << "  Queue Full Stalls: " << swap->fullStalls << " (" << swap->fullStallCycles << " cycles, peak depth "
+                  << swap->peakQueue << ")\n";
+        std::cout << "  Paging Clock: " << clock << " cycles\n";
     }
-    std::cout << "Hits: " << pageHits << " | Faults: " << pageFaults << "\n";
+}
+
+void PhysicalMemory::registerStats(stats::Registry &registry)
+{
+    statFaults = registry.counter("vm.page_faults");
+    statHits = registry.counter("vm.page_hits");
+    statEvictions = registry.counter("vm.evictions");
+    statFaultsByPid = registry.labeledCounter("vm.faults_by_pid");
+    statEvictionsByPid = registry.labeledCounter("vm.evictions_by_pid");
+    statMajorFaults = registry.counter("vm.major_faults");
+    statSwapOuts = registry.counter("vm.swap_outs");
+}
+
+void PhysicalMemory::save(CheckpointWriter &out) const
+{
+    // with coloring on, frames below the watermark not in use become the free list
+    std::vector<FrameNumber> unused;
+    size_t watermark = freeFrameList(unused);
+    out.put<uint64_t>(pagesize);
+    out.put<uint64_t>(numFrames);
+    out.put<uint8_t>(isLRU);
+    out.put<uint64_t>(pageFaults);
+    out.put<uint64_t>(pageHits);
+    out.put<uint64_t>(watermark);
+    out.put<uint8_t>(usedFrames == numFrames);
+    out.put<int64_t>(fifoPointer);
+    // only frames in use, so the size follows resident pages, not RAM
+    out.put<uint64_t>(usedFrames);
+    frames.forEach([&](size_t f, const FrameInfo &frame) {
+        if (!frame.used())
+            return;
+        out.put<uint64_t>(f);
+        out.put<uint64_t>(frame.ownerVPN);
+        out.put<int32_t>(frame.ownerPID);
+    });
+    out.put<uint64_t>(lruList.size());
+    for (FrameNumber frame : lruList)
+        out.put<int64_t>(frame);
+}
+
+std::unique_ptr<PhysicalMemory> PhysicalMemory::restore(CheckpointReader &in)
+{
+    uint64_t pageSize = in.get<uint64_t>();
+    uint64_t nFrames = in.get<uint64_t>();
+    bool lru = in.get<uint8_t>();
+    if (!in.ok() || pageSize == 0 || nFrames == 0 || nFrames > SIZE_MAX / pageSize)
+    {
+        in.fail("corrupt frame table geometry");
+        return nullptr;
+    }
+    auto pm = std::make_unique<PhysicalMemory>(nFrames * pageSize, pageSize, lru);
+    pm->pageFaults = in.get<uint64_t>();
+    pm->pageHits = in.get<uint64_t>();
+    pm->nextFreeFrameIndex = in.get<uint64_t>();
+    in.get<uint8_t>(); // full flag, recomputed below
+    pm->fifoPointer = in.get<int64_t>();
+    uint64_t usedCount = in.getCount(2 * sizeof(uint64_t) + sizeof(int32_t));
+    for (uint64_t i = 0; i < usedCount && in.ok(); i++)
+    {
+        uint64_t f = in.get<uint64_t>();
+        uint64_t vpn = in.get<uint64_t>();
+        int32_t pid = in.get<int32_t>();
+        if (f >= nFrames || pm->frames[f].used())
+        {
+            in.fail("corrupt frame table");
+            return nullptr;
+        }
+        FrameInfo &frame = pm->frames[f];
+        frame.ownerVPN = vpn;
+        frame.ownerPID = pid;
+        frame.refCount = 1;
+        pm->usedFrames++;
+    }
+    uint64_t lruCount = in.getCount(sizeof(int64_t));
+    for (uint64_t i = 0; i < lruCount && in.ok(); i++)
+    {
+        int64_t frame = in.get<int64_t>();
+        if (frame < 0 || (uint64_t)frame >= nFrames || pm->lruMap.count(frame))
+        {
+            in.fail("corrupt LRU order");
+            return nullptr;
+        }
+        pm->lruList.push_back(frame);
+        pm->lruMap[frame] = std::prev(pm->lruList.end());
+    }
+    if (!in.ok() || pm->nextFreeFrameIndex > nFrames || pm->fifoPointer < 0 || (uint64_t)pm->fifoPointer >= nFrames)
+    {
+        in.fail("corrupt frame allocator state");
+        return nullptr;
+    }
+    for (size_t f = 0; f < pm->nextFreeFrameIndex; f++)
+    {
+        if (!pm->frames[f].used())
+            pm->freeFrames.push_back((FrameNumber)f);
+    }
+    return pm;
 }
 
 VirtualMemory::VirtualMemory(PhysicalMemory *pm, int pid_)
@@ -100,31 +822,208 @@ VirtualMemory::VirtualMemory(PhysicalMemory *pm)
     physMem->registerProcess(pid, this);
 }
 
-void VirtualMemory::invalidatePage(uint64_t vpn)
+int VirtualMemory::getPid() const
 {
-    if (pageTable.count(vpn))
+    return pid;
+}
+
+void VirtualMemory::save(CheckpointWriter &out) const
+{
+    out.put<int32_t>(pid);
+    out.put<uint64_t>(pageTable.size());
+    for (const auto &entry : pageTable)
+    {
+        out.put<uint64_t>(entry.first);
+        out.put<uint8_t>(entry.second.valid | entry.second.dirty << 1 | entry.second.cow << 2);
+        out.put<int64_t>(entry.second.frameNumber);
+    }
+}
+
+std::unique_ptr<VirtualMemory> VirtualMemory::restore(CheckpointReader &in, PhysicalMemory *pm)
+{
+    int32_t pid = in.get<int32_t>();
+    uint64_t count = in.getCount(sizeof(uint64_t) + 1 + sizeof(int64_t));
+    if (!in.ok())
+        return nullptr;
+    auto vm = std::make_unique<VirtualMemory>(pm, pid);
+    vm->pageTable.reserve(count);
+    for (uint64_t i = 0; i < count; i++)
     {
-        pageTable[vpn].valid = false;
-        pageTable[vpn].frameNumber = -1;
+        uint64_t vpn = in.get<uint64_t>();
+        PageTableEntry &pte = vm->pageTable[vpn];
+        uint8_t flags = in.get<uint8_t>();
+        pte.valid = flags & 1;
+        pte.dirty = (flags & 2) != 0;
+        pte.cow = (flags & 4) != 0;
+        pte.frameNumber = in.get<int64_t>();
+        if (in.ok() && pte.valid && !pm->mapsPage(pte.frameNumber, pid, vpn))
+        {
+            in.fail("page table does not match the frame table");
+            return nullptr;
+        }
+    }
+    if (!in.ok())
+        return nullptr;
+    return vm;
+}
+
+bool VirtualMemory::invalidatePage(uint64_t vpn)
+{
+    auto it = pageTable.find(vpn);
+    if (it == pageTable.end())
+        return false;
+    bool dirty = it->second.dirty;
+    it->second.valid = false;
+    it->second.dirty = false;
+    it->second.cow = false;
+    it->second.frameNumber = -1;
+    return dirty;
+}
+
+std::unique_ptr<VirtualMemory> VirtualMemory::fork(int childPid)
+{
+    auto child = std::make_unique<VirtualMemory>(physMem, childPid);
+    child->pageTable.reserve(pageTable.size());
+    for (auto &entry : pageTable)
+    {
+        PageTableEntry &pte = entry.second;
+        if (!pte.valid)
+        {
+            physMem->inheritSwapped(PageId{pid, entry.first}, PageId{childPid, entry.first});
+            continue;
+        }
+        pte.cow = true;
+        PageTableEntry &copy = child->pageTable[entry.first];
+        copy.valid = true;
+        // the shared frame holds whatever the parent wrote; whichever
+        // mapping outlives the other must still write it back
+        copy.dirty = pte.dirty;
+        copy.cow = true;
+        copy.frameNumber = pte.frameNumber;
+        physMem->share(pte.frameNumber, childPid, entry.first);
     }
+    physMem->forks++;
+    return child;
 }
 
-uint64_t VirtualMemory::translate(uint64_t virtualAddr)
+void VirtualMemory::release()
+{
+    for (const auto &entry : pageTable)
+    {
+        if (entry.second.valid)
+            physMem->unmap(entry.second.frameNumber, pid, entry.first);
+    }
+    pageTable.clear();
+    physMem->unregisterProcess(pid);
+    physMem->exits++;
+}
+
+size_t VirtualMemory::residentPages() const
+{
+    size_t count = 0;
+    for (const auto &entry : pageTable)
+        count += entry.second.valid;
+    return count;
+}
+
+void VirtualMemory::remapPage(uint64_t vpn, FrameNumber frameNumber)
+{
+    auto it = pageTable.find(vpn);
+    if (it != pageTable.end())
+        it->second.frameNumber = frameNumber;
+}
+
+uint64_t VirtualMemory::translate(uint64_t virtualAddr, bool write)
+{
+    return resolve(virtualAddr, write, true);
+}
+
+void VirtualMemory::translateBatch(const uint64_t *virtualAddrs, const bool *writes, size_t count, uint64_t *physicalAddrs)
+{
+    // Entries keep their address while translating (only release() erases
+    // them), so a block's lookups can all be done before the first resolves.
+    const size_t CHUNK = 256;
+    PageTableEntry *entries[CHUNK];
+    for (size_t base = 0; base < count; base += CHUNK)
+    {
+        size_t n = std::min(CHUNK, count - base);
+        for (size_t i = 0; i < n; i++)
+        {
+            auto it = pageTable.find(virtualAddrs[base + i] >> offsetBits);
+            entries[i] = it == pageTable.end() ? nullptr : &it->second;
+            if (entries[i] && entries[i]->valid)
+                physMem->prefetchFrame(entries[i]->frameNumber);
+        }
+        for (size_t i = 0; i < n; i++)
+        {
+            uint64_t virtualAddr = virtualAddrs[base + i];
+            // a page first seen in this block is inserted now, in order
+            PageTableEntry &pte = entries[i] ? *entries[i] : pageTable[virtualAddr >> offsetBits];
+            physicalAddrs[base + i] = resolve(pte, virtualAddr, writes[base + i], true);
+        }
+    }
+}
+uint64_t VirtualMemory::warm(uint64_t virtualAddr, bool write)
+{
+    return resolve(virtualAddr, write, false);
+}
+
+uint64_t VirtualMemory::resolve(uint64_t virtualAddr, bool write, bool detailed)
+{
+    return resolve(pageTable[virtualAddr >> offsetBits], virtualAddr, write, detailed);
+}
+uint64_t VirtualMemory::resolve(PageTableEntry &pte, uint64_t virtualAddr, bool write, bool detailed)
 {
     uint64_t vpn = virtualAddr >> offsetBits;
     uint64_t offset = virtualAddr & ((1ULL << offsetBits) - 1);
-    if (pageTable[vpn].valid)
+    if (detailed)
+    {
+        physMem->clock++;
+        if (FaultCurve *curve = physMem->faultCurve())
+            curve->reference(pid, vpn);
+    }
+    bool copy = false;
+    if (pte.valid && write && pte.cow)
     {
-        physMem->pageHits++;
-        int frame = pageTable[vpn].frameNumber;
+        pte.cow = false;
+        if (physMem->refCount(pte.frameNumber) > 1)
+        {
+            // still shared: this write faults and gets a private copy
+            physMem->unmap(pte.frameNumber, pid, vpn);
+            pte.valid = false;
+            copy = true;
+        }
+    }
+    if (pte.valid)
+    {
+        pte.dirty |= write;
+        if (detailed)
+        {
+            physMem->pageHits++;
+            STAT_INC(physMem->statHits);
+        }
+        FrameNumber frame = pte.frameNumber;
         physMem->access(frame);
-        return (frame << offsetBits) | offset;
+        if (detailed)
+            physMem->countAccess(frame);
+        return ((uint64_t)frame << offsetBits) | offset;
+    }
+    if (detailed)
+    {
+        physMem->pageFaults++;
+        STAT_INC(physMem->statFaults);
+        STAT_INC_LABEL(physMem->statFaultsByPid, pid);
     }
-    physMem->pageFaults++;
-    int newFrame = physMem->allocate(pid, vpn);
+    FrameNumber newFrame = physMem->allocate(pid, vpn, detailed);
+    if (copy && detailed)
+        physMem->cowCopies++;
 
-    pageTable[vpn].valid = true;
-    pageTable[vpn].frameNumber = newFrame;
+    pte.valid = true;
+    pte.dirty = write;
+    pte.cow = false;
+    pte.frameNumber = newFrame;
+    if (detailed)
+        physMem->countAccess(newFrame);
 
-    return (newFrame << offsetBits) | offset;
-}
\ No newline at end of file
+    return ((uint64_t)newFrame << offsetBits) | offset;
+}